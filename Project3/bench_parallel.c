@@ -0,0 +1,134 @@
+/*
+This file benchmarks the parallel merge sort in parallel_sort.h. The same
+pseudo-random array is sorted with the C library's qsort, with merge_sort on
+one thread, and with parallel_sort on 2, 4, 8, ... threads up to (and
+including) the number of online processors, and the speedup of each run over
+both single-threaded sorts is reported.
+
+usage: bench_parallel [n]   (default 100000000)
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "parallel_sort.h"
+
+#define DEFAULT_N 100000000L
+
+unsigned int seed;
+
+/* next_random returns the next number of a simple repeatable sequence */
+unsigned int next_random(void)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 1;
+}
+
+/* now returns the current wall-clock time in seconds */
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* compare_ints is the qsort comparison function for ints */
+int compare_ints(const void *a, const void *b)
+{
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+/* fill puts the same pseudo-random numbers in nums every time */
+void fill(int nums[], long n)
+{
+  long i;
+  seed = 12345u;
+  for (i = 0; i < n; i++)
+  {
+    nums[i] = (int)next_random();
+  }
+}
+
+/* check exits with an error if nums isn't sorted */
+void check(int nums[], long n, const char *what)
+{
+  long i;
+  for (i = 1; i < n; i++)
+  {
+    if (nums[i - 1] > nums[i])
+    {
+      fprintf(stderr, "%s didn't sort the array\n", what);
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  long n = DEFAULT_N;
+  int *nums, *tmp, threads, ncores = online_processors();
+  double start, qsort_time, merge_time, t;
+  char what[32];
+  if (argc > 2 || (argc == 2 && (n = atol(argv[1])) <= 0))
+  {
+    fprintf(stderr, "usage: %s [n]\n", argv[0]);
+    exit(1);
+  }
+  nums = (int *)malloc(n * sizeof(int));
+  tmp = (int *)malloc(n * sizeof(int));
+  if (nums == NULL || tmp == NULL)
+  {
+    fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+    exit(1);
+  }
+  printf("%ld values, %d processors online\n", n, ncores);
+  printf("%-16s %10s %14s %14s\n", "sort", "seconds", "vs qsort",
+         "vs merge_sort");
+
+  fill(nums, n);
+  start = now();
+  qsort(nums, n, sizeof(int), compare_ints);
+  qsort_time = now() - start;
+  check(nums, n, "qsort");
+  printf("%-16s %10.3f %14.2f\n", "qsort", qsort_time, 1.0);
+
+  fill(nums, n);
+  start = now();
+  merge_sort(nums, tmp, n);
+  merge_time = now() - start;
+  check(nums, n, "merge_sort");
+  printf("%-16s %10.3f %14.2f %14.2f\n", "merge_sort", merge_time,
+         qsort_time / merge_time, 1.0);
+  free(tmp);
+
+  for (threads = 2; ; threads *= 2)
+  {
+    if (threads > ncores)
+    {
+      threads = ncores;
+    }
+    if (threads < 2)
+    {
+      break;
+    }
+    fill(nums, n);
+    start = now();
+    parallel_sort(nums, n, threads);
+    t = now() - start;
+    sprintf(what, "parallel (%d)", threads);
+    check(nums, n, what);
+    printf("%-16s %10.3f %14.2f %14.2f\n", what, t, qsort_time / t,
+           merge_time / t);
+    if (threads == ncores)
+    {
+      break;
+    }
+  }
+
+  free(nums);
+  return 0;
+}
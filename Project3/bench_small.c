@@ -0,0 +1,99 @@
+/*
+This file is a microbenchmark of the sorts for tiny arrays: it reports the
+average time in nanoseconds to sort one random array of each size from 2 to
+64 with each sort. Build with 'make SIMDFLAGS="-O2 -mavx2" bench_small' to
+measure the AVX2 networks in small_sort.
+
+usage: bench_small [sorts per size]   (default 200000)
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sorts.h"
+#include "small_sort.h"
+
+#define DEFAULT_ROUNDS 200000L
+#define MAX_SIZE       64
+#define POOL           (1L << 20)
+#define NSORTS         5
+
+unsigned int seed = 12345u;
+
+/* next_random returns the next number of a simple repeatable sequence */
+unsigned int next_random(void)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 1;
+}
+
+/* now returns the current wall-clock time in seconds */
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+const char *sort_names[NSORTS] =
+  { "minimum", "bubble", "insertion", "branchless", "small_sort" };
+void (*sorts[NSORTS])(int nums[], long len) =
+  { minimum_entry_sort, bubble_sort, insertion_sort,
+    branchless_insertion_sort, small_sort };
+
+int main(int argc, char *argv[])
+{
+  long rounds = DEFAULT_ROUNDS, i, offset;
+  int *pool, nums[MAX_SIZE], size, s;
+  double start;
+  if (argc > 2 || (argc == 2 && (rounds = atol(argv[1])) <= 0))
+  {
+    fprintf(stderr, "usage: %s [sorts per size]\n", argv[0]);
+    exit(1);
+  }
+  /* the arrays to sort are cut from a pool of random numbers */
+  pool = (int *)malloc(POOL * sizeof(int));
+  if (pool == NULL)
+  {
+    fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+    exit(1);
+  }
+  for (i = 0; i < POOL; i++)
+  {
+    pool[i] = (int)next_random();
+  }
+  printf("nanoseconds per sort (small_sort uses %s)\n",
+         small_sort_network ? "AVX2 networks" : "insertion");
+  printf("%4s", "size");
+  for (s = 0; s < NSORTS; s++)
+  {
+    printf(" %11s", sort_names[s]);
+  }
+  printf("\n");
+  for (size = 2; size <= MAX_SIZE; size++)
+  {
+    printf("%4d", size);
+    for (s = 0; s < NSORTS; s++)
+    {
+      offset = 0;
+      start = now();
+      for (i = 0; i < rounds; i++)
+      {
+        memcpy(nums, pool + offset, size * sizeof(int));
+        sorts[s](nums, size);
+        offset += size;
+        if (offset + MAX_SIZE > POOL)
+        {
+          offset = 0;
+        }
+      }
+      printf(" %11.1f", (now() - start) / rounds * 1e9);
+    }
+    printf("\n");
+  }
+  free(pool);
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+This file prints a table of how long each of the sorts in sorts.h and
+parallel_sort.h takes on several input distributions of the same size. The
+O(n^2) sorts are only run when n is at most QUADRATIC_MAX; otherwise their
+cells show "-". Naming some sorts after n runs only those.
+
+usage: bench_sorts [n [sort ...]]   (default 1000000, every sort)
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sorts.h"
+#include "parallel_sort.h"
+
+#define DEFAULT_N     1000000L
+#define QUADRATIC_MAX 50000L
+#define NSORTS        7
+#define NINPUTS       7
+
+unsigned int seed;
+
+/* next_random returns the next number of a simple repeatable sequence */
+unsigned int next_random(void)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 1;
+}
+
+/* now returns the current wall-clock time in seconds */
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* parallel runs parallel_sort on every processor */
+void parallel(int nums[], long len)
+{
+  parallel_sort(nums, len, 0);
+}
+
+const char *sort_names[NSORTS] =
+  { "minimum", "bubble", "insertion", "heap", "intro", "radix", "parallel" };
+void (*sorts[NSORTS])(int nums[], long len) =
+  { minimum_entry_sort, bubble_sort, insertion_sort, heap_sort, introsort,
+    radix_sort, parallel };
+int quadratic[NSORTS] = { 1, 1, 1, 0, 0, 0, 0 };
+int selected[NSORTS];
+
+const char *input_names[NINPUTS] =
+  { "random", "sorted", "reversed", "16 distinct", "organ pipe",
+    "1% swapped", "skewed" };
+
+/* fill puts input distribution 'input' in nums */
+void fill(int nums[], long n, int input)
+{
+  long i, a, b;
+  int temp;
+  seed = 12345u;
+  for (i = 0; i < n; i++)
+  {
+    switch (input)
+    {
+      case 0: nums[i] = (int)next_random(); break;
+      case 1: nums[i] = (int)i; break;
+      case 2: nums[i] = (int)(n - i); break;
+      case 3: nums[i] = (int)(next_random() % 16); break;
+      case 4: nums[i] = (int)(i < n / 2 ? i : n - i); break;
+      /* mostly small numbers: a random number shifted right 0 to 30 bits */
+      case 6: nums[i] = (int)(next_random() >> (next_random() % 31)); break;
+      default: nums[i] = (int)i; break;
+    }
+  }
+  if (input == 5)
+  {
+    for (i = 0; i < n / 100; i++)
+    {
+      a = next_random() % n;
+      b = next_random() % n;
+      temp = nums[a];
+      nums[a] = nums[b];
+      nums[b] = temp;
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  long n = DEFAULT_N, i;
+  int *nums, s, input, a;
+  double start;
+  if (argc >= 2 && (n = atol(argv[1])) <= 0)
+  {
+    fprintf(stderr, "usage: %s [n [sort ...]]\n", argv[0]);
+    exit(1);
+  }
+  for (s = 0; s < NSORTS; s++)
+  {
+    selected[s] = (argc <= 2);
+    for (a = 2; a < argc; a++)
+    {
+      if (strcmp(argv[a], sort_names[s]) == 0)
+      {
+        selected[s] = 1;
+      }
+    }
+  }
+  nums = (int *)malloc(n * sizeof(int));
+  if (nums == NULL)
+  {
+    fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+    exit(1);
+  }
+  printf("%ld values (seconds)\n%-12s", n, "input");
+  for (s = 0; s < NSORTS; s++)
+  {
+    if (selected[s])
+    {
+      printf(" %10s", sort_names[s]);
+    }
+  }
+  printf("\n");
+  for (input = 0; input < NINPUTS; input++)
+  {
+    printf("%-12s", input_names[input]);
+    for (s = 0; s < NSORTS; s++)
+    {
+      if (!selected[s])
+      {
+        continue;
+      }
+      if (quadratic[s] && n > QUADRATIC_MAX)
+      {
+        printf(" %10s", "-");
+        continue;
+      }
+      fill(nums, n, input);
+      start = now();
+      sorts[s](nums, n);
+      printf(" %10.3f", now() - start);
+      fflush(stdout);
+      for (i = 1; i < n; i++)
+      {
+        if (nums[i - 1] > nums[i])
+        {
+          fprintf(stderr, "\n%s failed on %s input\n", sort_names[s],
+                  input_names[input]);
+          exit(1);
+        }
+      }
+    }
+    printf("\n");
+  }
+  free(nums);
+  return 0;
+}
@@ -0,0 +1,558 @@
+/*
+This file implements the external merge sort declared in external_sort.h.
+
+The memory budget is spent in two phases:
+
+  1. run formation: a chunk of budget / 8 ints is filled from the input and
+     sorted with radix_sort, which needs a scratch array of the same size,
+     and then written to a temporary file with a single fwrite. If the whole
+     input fits in one chunk it is written straight to the output instead;
+  2. merging: the chunk is freed and the budget is split evenly between one
+     read buffer per run being merged and the output buffer, none of them
+     smaller than EXTERNAL_MIN_BUFFER. That limits how many runs can be
+     merged at once (the fan-in); while there are more runs than that, each
+     pass merges groups of them into longer runs, and the last pass merges
+     into the output.
+
+A merge picks the next value with a loser tree: each internal node holds the
+run that lost the match played there, and the overall winner sits at the
+root, so replacing the winner with the next value of its run replays only
+the log2(k) matches on its path to the root, with one comparison each.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "external_sort.h"
+#include "sorts.h"
+#include "int_io.h"
+#include "sort_counters.h"
+
+/* run formation never works on chunks shorter than this */
+#define MIN_CHUNK 1024
+
+/*
+where sorted ints are written: a temporary file or the output, as binary
+records through buf, or as text through writer; fp is NULL if they are to be
+thrown away
+*/
+typedef struct
+{
+  FILE *fp;
+  int binary;
+  int *buf;
+  long size;
+  long used;
+  int_writer *writer;
+} int_sink;
+
+/* one run being merged, read a buffer at a time */
+typedef struct
+{
+  FILE *fp;
+  int *buf;
+  long len;
+  long pos;
+} run_reader;
+
+/*
+fatal prints an error message and exits
+*/
+static void fatal(const char *what)
+{
+  fprintf(stderr, "Fatal error: %s. Terminating program.\n", what);
+  exit(1);
+}
+
+static void *allocate(size_t bytes)
+{
+  void *p = malloc(bytes > 0 ? bytes : 1);
+  if (p == NULL)
+  {
+    fatal("out of memory");
+  }
+  return p;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+temp_file opens a new temporary file for reading and writing, which goes
+away when it is closed; it returns NULL after printing a message if it can't
+*/
+static FILE *temp_file(const char *tmpdir)
+{
+  char *path;
+  FILE *fp;
+  int fd;
+  if (tmpdir == NULL)
+  {
+    fp = tmpfile();
+    if (fp == NULL)
+    {
+      fprintf(stderr, "Error: can't create a temporary file\n");
+    }
+    return fp;
+  }
+  path = (char *)allocate(strlen(tmpdir) + sizeof("/sortXXXXXX"));
+  sprintf(path, "%s/sortXXXXXX", tmpdir);
+  fd = mkstemp(path);
+  if (fd == -1)
+  {
+    fprintf(stderr, "Error: can't create a temporary file in %s\n", tmpdir);
+    free(path);
+    return NULL;
+  }
+  /* the file lives on, nameless, until it is closed */
+  unlink(path);
+  free(path);
+  fp = fdopen(fd, "w+b");
+  if (fp == NULL)
+  {
+    fprintf(stderr, "Error: can't create a temporary file in %s\n", tmpdir);
+    close(fd);
+  }
+  return fp;
+}
+
+static void sink_init(int_sink *sink, FILE *fp, int binary, long size)
+{
+  sink->fp = fp;
+  sink->binary = binary;
+  sink->size = size;
+  sink->used = 0;
+  sink->buf = NULL;
+  sink->writer = NULL;
+  if (fp != NULL && binary)
+  {
+    sink->buf = (int *)allocate(size * sizeof(int));
+  }
+  else if (fp != NULL)
+  {
+    sink->writer = (int_writer *)allocate(sizeof(int_writer));
+    int_writer_init(sink->writer, fp);
+  }
+}
+
+/*
+sink_flush writes out everything buffered so far; it returns 0, or -1 after
+printing a message on a write error
+*/
+static int sink_flush(int_sink *sink)
+{
+  if (sink->buf != NULL && sink->used > 0)
+  {
+    if (fwrite(sink->buf, sizeof(int), sink->used, sink->fp)
+        != (size_t)sink->used)
+    {
+      fprintf(stderr, "Error: write failed\n");
+      return -1;
+    }
+    sink->used = 0;
+  }
+  else if (sink->writer != NULL && int_writer_flush(sink->writer) == -1)
+  {
+    return -1;
+  }
+  return 0;
+}
+
+static int sink_put(int_sink *sink, int value)
+{
+  if (sink->buf != NULL)
+  {
+    if (sink->used == sink->size && sink_flush(sink) == -1)
+    {
+      return -1;
+    }
+    sink->buf[sink->used++] = value;
+    return 0;
+  }
+  if (sink->writer != NULL)
+  {
+    return int_writer_put(sink->writer, value);
+  }
+  return 0;
+}
+
+/*
+sink_write writes nums[0..len-1]; binary records go out with a single fwrite
+rather than through the buffer
+*/
+static int sink_write(int_sink *sink, const int nums[], long len)
+{
+  long i;
+  if (sink->buf != NULL)
+  {
+    if (sink_flush(sink) == -1)
+    {
+      return -1;
+    }
+    if (fwrite(nums, sizeof(int), len, sink->fp) != (size_t)len)
+    {
+      fprintf(stderr, "Error: write failed\n");
+      return -1;
+    }
+    return 0;
+  }
+  for (i = 0; i < len; i++)
+  {
+    if (sink_put(sink, nums[i]) == -1)
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void sink_free(int_sink *sink)
+{
+  free(sink->buf);
+  free(sink->writer);
+}
+
+/*
+run_fill reads the next buffer of a run; it returns the number of ints read
+(0 at the end of the run), or -1 after printing a message on a read error
+*/
+static long run_fill(run_reader *run, long size)
+{
+  run->len = (long)fread(run->buf, sizeof(int), size, run->fp);
+  run->pos = 0;
+  if (run->len == 0 && ferror(run->fp))
+  {
+    fprintf(stderr, "Error: can't read a temporary file\n");
+    return -1;
+  }
+  return run->len;
+}
+
+/*
+BEATS is true if run a's current value comes before run b's; a run that has
+run out loses to everything
+*/
+#define BEATS(a, b) (!done[a] && (done[b] || LESS(key[a], key[b])))
+
+/*
+merge_runs merges the k sorted runs in runs[] into sink, reading each run
+through a buffer of size ints. It returns 0, or -1 after printing a message
+on a read or write error. The runs are left open.
+*/
+static int merge_runs(FILE *runs[], int k, int_sink *sink, long size)
+{
+  run_reader *readers;
+  int *key, *tree, *winners;
+  char *done;
+  int i, s, p, t, status = 0;
+  readers = (run_reader *)allocate(k * sizeof(run_reader));
+  key = (int *)allocate(k * sizeof(int));
+  done = (char *)allocate(k);
+  tree = (int *)allocate(k * sizeof(int));
+  winners = (int *)allocate(2 * k * sizeof(int));
+  for (i = 0; i < k; i++)
+  {
+    readers[i].fp = runs[i];
+    readers[i].buf = (int *)allocate(size * sizeof(int));
+    rewind(runs[i]);
+    switch (run_fill(&readers[i], size))
+    {
+    case -1:
+      status = -1;
+      /* fall through */
+    case 0:
+      done[i] = 1;
+      break;
+    default:
+      done[i] = 0;
+      key[i] = readers[i].buf[0];
+    }
+  }
+  /*
+  build the tree bottom up: leaf i is node k + i, the children of node p are
+  2p and 2p + 1, and the winner of the whole tree is kept in tree[0]
+  */
+  for (i = 0; i < k; i++)
+  {
+    winners[k + i] = i;
+  }
+  for (p = k - 1; p > 0; p--)
+  {
+    if (BEATS(winners[2 * p], winners[2 * p + 1]))
+    {
+      winners[p] = winners[2 * p];
+      tree[p] = winners[2 * p + 1];
+    }
+    else
+    {
+      winners[p] = winners[2 * p + 1];
+      tree[p] = winners[2 * p];
+    }
+  }
+  tree[0] = (k > 1) ? winners[1] : 0;
+  while (status == 0 && !done[tree[0]])
+  {
+    s = tree[0];
+    if (sink_put(sink, key[s]) == -1)
+    {
+      status = -1;
+      break;
+    }
+    COUNT_MOVES(1);
+    if (++readers[s].pos < readers[s].len)
+    {
+      key[s] = readers[s].buf[readers[s].pos];
+    }
+    else
+    {
+      switch (run_fill(&readers[s], size))
+      {
+      case -1:
+        status = -1;
+        /* fall through */
+      case 0:
+        done[s] = 1;
+        break;
+      default:
+        key[s] = readers[s].buf[0];
+      }
+    }
+    /* replay the matches on the path from leaf s to the root */
+    for (p = (s + k) / 2; p > 0; p /= 2)
+    {
+      if (BEATS(tree[p], s))
+      {
+        t = tree[p];
+        tree[p] = s;
+        s = t;
+      }
+    }
+    tree[0] = s;
+  }
+  for (i = 0; i < k; i++)
+  {
+    free(readers[i].buf);
+  }
+  free(readers);
+  free(key);
+  free(done);
+  free(tree);
+  free(winners);
+  return status;
+}
+
+static void close_runs(FILE *runs[], long count)
+{
+  long i;
+  for (i = 0; i < count; i++)
+  {
+    if (runs[i] != NULL)
+    {
+      fclose(runs[i]);
+    }
+  }
+}
+
+/*
+merge_pass merges the runs in groups of fan_in into new temporary files,
+replacing runs[0..*count-1] with the merged runs and updating *count. It
+returns 0, or -1 after printing a message.
+*/
+static int merge_pass(FILE *runs[], long *count, int fan_in, long memory,
+                      const char *tmpdir, long *spilled)
+{
+  int_sink sink;
+  FILE *merged;
+  long first, merged_count = 0;
+  int k;
+  for (first = 0; first < *count; first += k)
+  {
+    k = (*count - first < fan_in) ? (int)(*count - first) : fan_in;
+    if (k == 1)
+    {
+      runs[merged_count] = runs[first];
+      if (merged_count++ != first)
+      {
+        runs[first] = NULL;
+      }
+      continue;
+    }
+    if ((merged = temp_file(tmpdir)) == NULL)
+    {
+      return -1;
+    }
+    sink_init(&sink, merged, 1, memory / (k + 1) / (long)sizeof(int));
+    if (merge_runs(runs + first, k, &sink, memory / (k + 1) /
+                   (long)sizeof(int)) == -1 || sink_flush(&sink) == -1)
+    {
+      sink_free(&sink);
+      fclose(merged);
+      return -1;
+    }
+    sink_free(&sink);
+    *spilled += ftell(merged);
+    close_runs(runs + first, k);
+    memset(runs + first, 0, k * sizeof(FILE *));
+    runs[merged_count++] = merged;
+  }
+  /* the merged runs all sit in front of any that haven't been closed */
+  *count = merged_count;
+  return 0;
+}
+
+int external_sort(FILE *in, int binary_in, FILE *out, int binary_out,
+                  long memory, const char *tmpdir, external_stats *stats)
+{
+  external_stats local;
+  int_reader *reader;
+  int_sink sink;
+  FILE **runs = NULL, **bigger;
+  long chunk_len, n, count = 0, size = 0;
+  int status = 1, fan_in, k, next, have_next = 0;
+  int *chunk;
+  double start;
+  if (stats == NULL)
+  {
+    stats = &local;
+  }
+  memset(stats, 0, sizeof(external_stats));
+  chunk_len = memory / (2 * (long)sizeof(int));
+  if (chunk_len < MIN_CHUNK)
+  {
+    chunk_len = MIN_CHUNK;
+  }
+  fan_in = (int)(memory / EXTERNAL_MIN_BUFFER) - 1;
+  if (fan_in < 2)
+  {
+    fan_in = 2;
+  }
+  /* a merge's buffers share the budget, but none gets less than the minimum */
+  if ((memory / (fan_in + 1)) < EXTERNAL_MIN_BUFFER)
+  {
+    memory = (long)(fan_in + 1) * EXTERNAL_MIN_BUFFER;
+  }
+
+  /* phase 1: sorted runs */
+  start = now();
+  reader = (int_reader *)allocate(sizeof(int_reader));
+  int_reader_init(reader, in, binary_in);
+  chunk = (int *)allocate(chunk_len * sizeof(int));
+  while (status == 1)
+  {
+    n = 0;
+    if (have_next)
+    {
+      chunk[n++] = next;
+      have_next = 0;
+    }
+    while (n < chunk_len && (status = int_reader_next(reader, &chunk[n])) == 1)
+    {
+      n++;
+    }
+    if (status == 1 && count == 0)
+    {
+      /*
+      the first chunk is full; read one value ahead, so that input which
+      exactly fills it is sorted in memory rather than spilled as one run
+      */
+      status = int_reader_next(reader, &next);
+      have_next = (status == 1);
+    }
+    if (status == -1 || (n == 0 && count > 0))
+    {
+      break;
+    }
+    radix_sort(chunk, n);
+    stats->values += n;
+    if (status == 0 && count == 0)
+    {
+      /* everything fit in one chunk, so there is nothing to merge */
+      stats->runs = (n > 0);
+      stats->run_seconds = now() - start;
+      start = now();
+      sink_init(&sink, out, binary_out, EXTERNAL_MIN_BUFFER / sizeof(int));
+      if (sink_write(&sink, chunk, n) == -1 || sink_flush(&sink) == -1)
+      {
+        status = -1;
+      }
+      sink_free(&sink);
+      stats->merge_seconds = now() - start;
+      free(chunk);
+      free(reader);
+      return status;
+    }
+    if (count == size)
+    {
+      size = (size == 0) ? 16 : 2 * size;
+      bigger = (FILE **)realloc(runs, size * sizeof(FILE *));
+      if (bigger == NULL)
+      {
+        fatal("out of memory");
+      }
+      runs = bigger;
+    }
+    if ((runs[count] = temp_file(tmpdir)) == NULL)
+    {
+      status = -1;
+      break;
+    }
+    count++;
+    if (fwrite(chunk, sizeof(int), n, runs[count - 1]) != (size_t)n
+        || fflush(runs[count - 1]) != 0)
+    {
+      fprintf(stderr, "Error: can't write a temporary file\n");
+      status = -1;
+      break;
+    }
+    stats->spilled += n * (long)sizeof(int);
+  }
+  free(chunk);
+  free(reader);
+  stats->runs = count;
+  stats->run_seconds = now() - start;
+  if (status == -1)
+  {
+    close_runs(runs, count);
+    free(runs);
+    return -1;
+  }
+
+  /* phase 2: merge passes until one merge can write the output */
+  start = now();
+  while (count > fan_in)
+  {
+    if (merge_pass(runs, &count, fan_in, memory, tmpdir, &stats->spilled)
+        == -1)
+    {
+      close_runs(runs, count);
+      free(runs);
+      return -1;
+    }
+    stats->passes++;
+  }
+  k = (int)count;
+  sink_init(&sink, out, binary_out, memory / (k + 1) / (long)sizeof(int));
+  if (merge_runs(runs, k, &sink, memory / (k + 1) / (long)sizeof(int)) == -1
+      || sink_flush(&sink) == -1)
+  {
+    status = -1;
+  }
+  else
+  {
+    status = 0;
+  }
+  stats->passes++;
+  sink_free(&sink);
+  close_runs(runs, count);
+  free(runs);
+  stats->merge_seconds = now() - start;
+  return status;
+}
@@ -0,0 +1,49 @@
+/*
+This file declares an external merge sort for streams of ints too big to hold
+in memory. The input is read a chunk at a time; each chunk is sorted with
+radix_sort (see sorts.h) and spilled to a temporary file as a sorted run, and
+then the runs are merged, as many at a time as the memory budget allows, with
+a loser tree. Runs are read and written in large blocks, so the disk sees
+long sequential transfers rather than one small request per value.
+*/
+
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <stdio.h>
+
+/* the memory budget sorter uses unless told otherwise, in megabytes */
+#define EXTERNAL_DEFAULT_MB 256
+
+/* no run is read through a buffer smaller than this many bytes */
+#define EXTERNAL_MIN_BUFFER 65536
+
+/*
+what external_sort reports about its work; "spilled" counts the bytes
+written to temporary files, and "passes" the merge passes over the data
+(0 if the input fit in memory and was never spilled)
+*/
+typedef struct
+{
+  long values;
+  long runs;
+  int passes;
+  long spilled;
+  double run_seconds;
+  double merge_seconds;
+} external_stats;
+
+/*
+external_sort reads ints from in (binary int32 records if binary_in is
+nonzero, otherwise whitespace separated text), and writes them to out from
+least to greatest (binary records if binary_out is nonzero, otherwise one per
+line); out may be NULL to sort without writing anything. It uses about
+memory bytes of buffers, and keeps its runs in temporary files in tmpdir, or
+in tmpfile()'s directory if tmpdir is NULL. Stats are stored in *stats
+unless it is NULL. Returns 0, or -1 after printing a message on bad input or
+a read or write error; running out of memory is fatal.
+*/
+int external_sort(FILE *in, int binary_in, FILE *out, int binary_out,
+                  long memory, const char *tmpdir, external_stats *stats);
+
+#endif
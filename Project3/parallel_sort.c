@@ -0,0 +1,271 @@
+/*
+This file implements the parallel merge sort declared in parallel_sort.h.
+
+Every thread runs the same steps, with a barrier between them:
+
+  1. merge sort its own chunk of the array;
+  2. for each round of merging, merge its share of the output. Runs of
+     2^round chunks are merged pairwise from one buffer into the other, and
+     the whole output is divided into equal slices, one per thread. For each
+     merge a slice overlaps, the thread finds where the slice starts and ends
+     in the two input runs by binary search (the "co-rank"), and merges just
+     that part;
+  3. if the result ended up in the scratch buffer, copy its slice back.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "parallel_sort.h"
+#include "small_sort.h"
+#include "sort_counters.h"
+
+/* what all the threads of one parallel_sort share */
+typedef struct
+{
+  int *nums;
+  int *tmp;
+  long len;
+  int nthreads;
+  pthread_barrier_t barrier;
+} sort_job;
+
+/* what each thread is told */
+typedef struct
+{
+  sort_job *job;
+  int id;
+} sort_worker;
+
+/*
+merge merges the sorted arrays a[0..alen-1] and b[0..blen-1] into out; on
+equal values a comes first, so the sort is stable
+*/
+static void merge(const int a[], long alen, const int b[], long blen, int out[])
+{
+  long i = 0, j = 0, k = 0;
+  while (i < alen && j < blen)
+  {
+    out[k++] = LESS(b[j], a[i]) ? b[j++] : a[i++];
+  }
+  COUNT_MOVES(alen + blen);
+  memcpy(out + k, a + i, (alen - i) * sizeof(int));
+  memcpy(out + k + alen - i, b + j, (blen - j) * sizeof(int));
+}
+
+/*
+merge_sort_to sorts src[0..len-1]; the result goes to dst if to_dst is
+nonzero, otherwise back into src. The other array is used as scratch.
+*/
+static void merge_sort_to(int src[], int dst[], long len, int to_dst)
+{
+  long half = len / 2;
+  if (len <= small_sort_cutoff)
+  {
+    small_sort(src, len);
+    if (to_dst)
+    {
+      memcpy(dst, src, len * sizeof(int));
+      COUNT_MOVES(len);
+    }
+    return;
+  }
+  /* sort both halves into the array we are not merging into */
+  merge_sort_to(src, dst, half, !to_dst);
+  merge_sort_to(src + half, dst + half, len - half, !to_dst);
+  if (to_dst)
+  {
+    merge(src, half, src + half, len - half, dst);
+  }
+  else
+  {
+    merge(dst, half, dst + half, len - half, src);
+  }
+}
+
+void merge_sort(int nums[], int tmp[], long len)
+{
+  merge_sort_to(nums, tmp, len, 0);
+}
+
+/*
+co_rank returns how many of the first k elements of the stable merge of
+a[0..alen-1] and b[0..blen-1] come from a
+*/
+static long co_rank(long k, const int a[], long alen, const int b[], long blen)
+{
+  long lo = (k > blen) ? k - blen : 0;
+  long hi = (k < alen) ? k : alen;
+  long i;
+  /* find the smallest i for which a[i] would be taken after b[k-i-1] */
+  while (lo < hi)
+  {
+    i = lo + (hi - lo) / 2;
+    if (k - i - 1 >= 0 && k - i - 1 < blen && a[i] <= b[k - i - 1])
+    {
+      lo = i + 1;
+    }
+    else
+    {
+      hi = i;
+    }
+  }
+  return lo;
+}
+
+/* chunk_start returns where chunk c of the array begins */
+static long chunk_start(sort_job *job, long c)
+{
+  if (c >= job->nthreads)
+  {
+    return job->len;
+  }
+  return job->len / job->nthreads * c
+         + (job->len % job->nthreads) * c / job->nthreads;
+}
+
+/*
+merge_slice does this thread's share, output positions [lo, hi), of one round
+of merges of runs 'width' chunks long from src into dst
+*/
+static void merge_slice(sort_job *job, const int src[], int dst[], long width,
+                        long lo, long hi)
+{
+  long run, start, mid, end, first, last, i0, i1;
+  for (run = 0; run < job->nthreads; run += 2 * width)
+  {
+    start = chunk_start(job, run);
+    mid = chunk_start(job, run + width);
+    end = chunk_start(job, run + 2 * width);
+    if (end <= lo || start >= hi)
+    {
+      continue;
+    }
+    /* the part of this merge's output that is in our slice */
+    first = (lo > start ? lo : start) - start;
+    last = (hi < end ? hi : end) - start;
+    i0 = co_rank(first, src + start, mid - start, src + mid, end - mid);
+    i1 = co_rank(last, src + start, mid - start, src + mid, end - mid);
+    merge(src + start + i0, i1 - i0, src + mid + (first - i0),
+          (last - i1) - (first - i0), dst + start + first);
+  }
+}
+
+/*
+sort_thread is the body of every thread, including the calling one
+*/
+static void *sort_thread(void *arg)
+{
+  sort_worker *worker = (sort_worker *)arg;
+  sort_job *job = worker->job;
+  long lo = chunk_start(job, worker->id);
+  long hi = chunk_start(job, worker->id + 1);
+  long width;
+  int *src = job->nums, *dst = job->tmp, *swap;
+  merge_sort(job->nums + lo, job->tmp + lo, hi - lo);
+  for (width = 1; width < job->nthreads; width *= 2)
+  {
+    pthread_barrier_wait(&job->barrier);
+    merge_slice(job, src, dst, width, lo, hi);
+    swap = src;
+    src = dst;
+    dst = swap;
+  }
+  if (src != job->nums)
+  {
+    pthread_barrier_wait(&job->barrier);
+    memcpy(job->nums + lo, src + lo, (hi - lo) * sizeof(int));
+    COUNT_MOVES(hi - lo);
+  }
+  return NULL;
+}
+
+int online_processors(void)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0) ? (int)n : 1;
+}
+
+/*
+fatal prints an error message and exits
+*/
+static void fatal(const char *what)
+{
+  fprintf(stderr, "Fatal error: %s. Terminating program.\n", what);
+  exit(1);
+}
+
+void parallel_sort(int nums[], long len, int nthreads)
+{
+  sort_job job;
+  sort_worker *workers;
+  pthread_t *threads;
+  int i;
+  if (nthreads <= 0)
+  {
+    nthreads = online_processors();
+  }
+  /* every thread needs a worthwhile chunk */
+  if (len / nthreads < PARALLEL_SORT_MIN / 2)
+  {
+    nthreads = (int)(len / (PARALLEL_SORT_MIN / 2));
+    if (nthreads < 1)
+    {
+      nthreads = 1;
+    }
+  }
+  job.nums = nums;
+  job.len = len;
+  job.nthreads = nthreads;
+  job.tmp = (int *)malloc((len > 0 ? len : 1) * sizeof(int));
+  if (job.tmp == NULL)
+  {
+    fatal("out of memory");
+  }
+  if (nthreads == 1)
+  {
+    merge_sort(nums, job.tmp, len);
+    free(job.tmp);
+    return;
+  }
+  workers = (sort_worker *)malloc(nthreads * sizeof(sort_worker));
+  threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+  if (workers == NULL || threads == NULL)
+  {
+    fatal("out of memory");
+  }
+  if (pthread_barrier_init(&job.barrier, NULL, nthreads) != 0)
+  {
+    fatal("can't create barrier");
+  }
+  /* the calling thread is worker 0 */
+  for (i = 0; i < nthreads; i++)
+  {
+    workers[i].job = &job;
+    workers[i].id = i;
+  }
+  for (i = 1; i < nthreads; i++)
+  {
+    /*
+    threads that have already started would wait at the barrier forever,
+    so there is no way to carry on without this one
+    */
+    if (pthread_create(&threads[i], NULL, sort_thread, &workers[i]) != 0)
+    {
+      fatal("can't create thread");
+    }
+  }
+  sort_thread(&workers[0]);
+  for (i = 1; i < nthreads; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  pthread_barrier_destroy(&job.barrier);
+  free(job.tmp);
+  free(workers);
+  free(threads);
+}
@@ -0,0 +1,34 @@
+/*
+This file declares a parallel merge sort for arrays of ints, built on POSIX
+threads. The array is cut into one chunk per thread, each thread sorts its own
+chunk, and then the sorted runs are merged pairwise in rounds. In every round
+the output is split evenly between all the threads using "merge path"
+partitioning, so every thread stays busy until the last merge.
+*/
+
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+/* arrays shorter than this are sorted on the calling thread */
+#define PARALLEL_SORT_MIN 65536
+
+/*
+parallel_sort sorts nums[0..len-1] from least to greatest using nthreads
+threads (the number of online processors if nthreads <= 0), with a scratch
+buffer as big as the array. Fewer threads are used if the chunks would be
+shorter than PARALLEL_SORT_MIN / 2. Like running out of memory, failing to
+create a thread is a fatal error.
+*/
+void parallel_sort(int nums[], long len, int nthreads);
+
+/*
+merge_sort sorts nums[0..len-1] from least to greatest on the calling thread,
+using tmp[0..len-1] as scratch space. It is the per-chunk sort used by
+parallel_sort.
+*/
+void merge_sort(int nums[], int tmp[], long len);
+
+/* online_processors returns the number of processors currently online */
+int online_processors(void);
+
+#endif
@@ -0,0 +1,229 @@
+/*
+This file implements the small-array sorts declared in small_sort.h.
+
+The AVX2 network is the usual bitonic sort on 8 * R lanes (R = 1, 2, 4 or 8
+registers). For each stage k = 2, 4, ..., 8R and step j = k/2, ..., 1, lane i
+is compared with lane i ^ j and keeps the smaller value if bit j of i is
+clear, unless bit k of i is set, which reverses the direction. Steps with
+j >= 8 compare whole registers with each other; smaller steps permute the
+lanes of one register, take the min and max with the permuted copy, and
+blend. Unused lanes are padded with INT_MAX so they sort to the end.
+*/
+
+#include <limits.h>
+#include <string.h>
+#include "small_sort.h"
+#include "sort_counters.h"
+
+/*
+the network is only built when optimizing as well: at -O0 none of the
+intrinsics are inlined, each becomes a function call, and the network loses
+to insertion sort
+*/
+#if defined(__AVX2__) && defined(__OPTIMIZE__)
+#define USE_NETWORK
+#endif
+
+#ifdef USE_NETWORK
+#include <immintrin.h>
+const int small_sort_network = 1;
+const long small_sort_cutoff = SMALL_SORT_MAX / 2;
+#else
+const int small_sort_network = 0;
+const long small_sort_cutoff = 16;
+#endif
+
+/*
+compare_exchange puts the smaller of *a and *b in *a and the larger in *b,
+choosing with a mask made from the comparison rather than with a branch
+*/
+
+static void compare_exchange(int *a, int *b)
+{
+  unsigned int x = (unsigned int)*a, y = (unsigned int)*b;
+  unsigned int swap = 0u - (unsigned int)(*a > *b);
+  unsigned int diff = (x ^ y) & swap;
+  *a = (int)(x ^ diff);
+  *b = (int)(y ^ diff);
+  COUNT_COMPARISONS(1);
+  COUNT_MOVES(2);
+}
+
+void branchless_insertion_sort(int nums[], long len)
+{
+  long i, j;
+  /*
+  nums[0..i-1] is sorted, so compare-exchanging nums[i] down the array
+  carries it to its place and leaves everything it passes where it was
+  */
+  for (i = 1; i < len; i++)
+  {
+    for (j = i; j > 0; j--)
+    {
+      compare_exchange(&nums[j - 1], &nums[j]);
+    }
+  }
+}
+
+/*
+insertion_sort sorts nums[0..len-1] by moving each value left past the
+larger values before it; on sorted or nearly sorted input it is linear
+*/
+
+static void insertion_sort(int nums[], long len)
+{
+  long i, j;
+  int value;
+  for (i = 1; i < len; i++)
+  {
+    value = nums[i];
+    for (j = i; j > 0 && LESS(value, nums[j - 1]); j--)
+    {
+      nums[j] = nums[j - 1];
+      COUNT_MOVES(1);
+    }
+    nums[j] = value;
+    COUNT_MOVES(1);
+  }
+}
+
+#ifdef USE_NETWORK
+
+/*
+bitonic_sort sorts the 8 * nregs values in v[0..nregs-1] (nregs a power of
+two) so that v[0] holds the smallest eight in order, v[1] the next eight, and
+so on
+*/
+
+static void bitonic_sort(__m256i v[], int nregs)
+{
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i partner, mn, mx, lower, desc, take_min;
+  int n = 8 * nregs, k, j, r, r2;
+  for (k = 2; k <= n; k *= 2)
+  {
+    for (j = k / 2; j > 0; j /= 2)
+    {
+      if (j >= 8)
+      {
+        /* lane i of register r meets lane i of register r + j/8 */
+        for (r = 0; r < nregs; r++)
+        {
+          r2 = r + j / 8;
+          if ((r * 8) & j)
+          {
+            continue;
+          }
+          mn = _mm256_min_epi32(v[r], v[r2]);
+          mx = _mm256_max_epi32(v[r], v[r2]);
+          COUNT_COMPARISONS(8);
+          if ((r * 8) & k)
+          {
+            v[r] = mx;
+            v[r2] = mn;
+          }
+          else
+          {
+            v[r] = mn;
+            v[r2] = mx;
+          }
+        }
+        continue;
+      }
+      /* lanes with bit j clear keep the min unless the direction flips */
+      lower = _mm256_cmpeq_epi32(_mm256_and_si256(lanes, _mm256_set1_epi32(j)),
+                                 zero);
+      for (r = 0; r < nregs; r++)
+      {
+        if (k < 8)
+        {
+          desc = _mm256_cmpeq_epi32(
+                   _mm256_and_si256(lanes, _mm256_set1_epi32(k)),
+                   _mm256_set1_epi32(k));
+        }
+        else
+        {
+          desc = _mm256_set1_epi32(((r * 8) & k) ? -1 : 0);
+        }
+        take_min = _mm256_xor_si256(lower, desc);
+        partner = _mm256_permutevar8x32_epi32(
+                    v[r], _mm256_xor_si256(lanes, _mm256_set1_epi32(j)));
+        mn = _mm256_min_epi32(v[r], partner);
+        mx = _mm256_max_epi32(v[r], partner);
+        v[r] = _mm256_blendv_epi8(mx, mn, take_min);
+        COUNT_COMPARISONS(4);
+      }
+    }
+  }
+}
+
+/*
+network_sort sorts up to SMALL_SORT_MAX values with bitonic_sort, padding
+them out to the next 8, 16, 32 or 64 with INT_MAX
+*/
+
+static void network_sort(int nums[], long len)
+{
+  int buf[SMALL_SORT_MAX];
+  __m256i v[SMALL_SORT_MAX / 8];
+  int nregs = 1, r;
+  long i;
+  while (8 * nregs < len)
+  {
+    nregs *= 2;
+  }
+  memcpy(buf, nums, len * sizeof(int));
+  for (i = len; i < 8 * nregs; i++)
+  {
+    buf[i] = INT_MAX;
+  }
+  for (r = 0; r < nregs; r++)
+  {
+    v[r] = _mm256_loadu_si256((const __m256i *)(buf + 8 * r));
+  }
+  bitonic_sort(v, nregs);
+  for (r = 0; r < nregs; r++)
+  {
+    _mm256_storeu_si256((__m256i *)(buf + 8 * r), v[r]);
+  }
+  memcpy(nums, buf, len * sizeof(int));
+  COUNT_MOVES(len);
+}
+
+#endif
+
+void small_sort(int nums[], long len)
+{
+#ifdef USE_NETWORK
+  long i;
+#endif
+  if (len < 2)
+  {
+    return;
+  }
+#ifdef USE_NETWORK
+  if (len >= SMALL_SORT_NETWORK_MIN && len <= SMALL_SORT_MAX)
+  {
+    /*
+    the network does all its work even on sorted input, which quicksort
+    leaves in sorted partitions, so look for that first; on random input
+    the scan stops after a value or two
+    */
+    for (i = 1; i < len && !LESS(nums[i], nums[i - 1]); i++)
+    {
+    }
+    if (i < len)
+    {
+      network_sort(nums, len);
+    }
+    return;
+  }
+  if (len < SMALL_SORT_NETWORK_MIN)
+  {
+    branchless_insertion_sort(nums, len);
+    return;
+  }
+#endif
+  insertion_sort(nums, len);
+}
@@ -0,0 +1,48 @@
+/*
+This file declares sorts for small arrays, for finishing off the short
+partitions and runs of the larger sorts.
+
+When compiled for AVX2 with optimization (e.g. -O2 -mavx2), small_sort sorts
+from SMALL_SORT_NETWORK_MIN up to SMALL_SORT_MAX ints with a bitonic sorting
+network held in 8-lane vector registers, and shorter arrays with
+branchless_insertion_sort, whose compare-exchanges use bit masks instead of
+branches; neither branches on the values, so neither suffers mispredictions
+on random input. In other builds, and for longer arrays, it falls back to a
+plain insertion sort: unoptimized, the mask arithmetic costs more than the
+mispredictions it saves.
+*/
+
+#ifndef SMALL_SORT_H
+#define SMALL_SORT_H
+
+/*
+the shortest and longest arrays small_sort sorts with a network; below the
+minimum the fixed cost of a whole register is more than insertion takes
+*/
+#define SMALL_SORT_NETWORK_MIN 9
+#define SMALL_SORT_MAX         64
+
+/*
+small_sort_network is nonzero if small_sort was compiled with the AVX2
+network, and small_sort_cutoff is the longest array worth handing to it
+instead of partitioning further: SMALL_SORT_MAX / 2 with the network, and 16
+(where insertion stops paying) without. They are variables because only
+small_sort.c is built with SIMDFLAGS, so only it knows which build it is.
+*/
+extern const int small_sort_network;
+extern const long small_sort_cutoff;
+
+/*
+small_sort sorts nums[0..len-1] from least to greatest. It is meant for short
+arrays; it is O(n^2) beyond SMALL_SORT_MAX.
+*/
+void small_sort(int nums[], long len);
+
+/*
+branchless_insertion_sort sorts nums[0..len-1] from least to greatest by
+moving each value down past the larger values before it with compare-
+exchanges that use no data-dependent branches.
+*/
+void branchless_insertion_sort(int nums[], long len);
+
+#endif
@@ -0,0 +1,298 @@
+#! /usr/bin/env python3
+
+#
+# Benchmark suite for the sorters: Project3's sorter (arrays) and Project6's
+# quicksorter (linked lists).
+#
+# "run" generates each input distribution at each size as a binary int32
+# file, sorts it with every algorithm of both programs, and records the best
+# sort time over several repeats (as ns per element) along with the number of
+# comparisons and moves, which come from a second build of each program with
+# -DSORT_COUNTERS (the sorter_counted and quicksorter_counted make targets),
+# so counting doesn't slow down the timed runs.  The results are written as
+# JSON.
+#
+# "compare" matches up two JSON result files, e.g. from two builds or two
+# commits, and prints the change in ns per element; it exits with status 1 if
+# anything got slower by more than the threshold.
+#
+# usage: sort_benchmark.py run [options]       (see --help)
+#        sort_benchmark.py compare OLD.json NEW.json [--threshold 0.1]
+#
+
+import argparse, array, json, os, platform, random, re, subprocess, sys
+import tempfile, time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+# program -> (directory, make targets, binary, counted binary, algorithms,
+#             options that make the binary read a binary int32 file)
+PROGRAMS = {
+    'sorter': (HERE, ['sorter', 'sorter_counted'], 'sorter',
+               'sorter_counted',
+               ['minimum', 'bubble', 'insertion', 'heap', 'intro', 'radix',
+                'parallel'],
+               ['-B', '-f']),
+    'quicksorter': (os.path.join(HERE, '..', 'Project6'),
+                    ['quicksorter', 'quicksorter_counted'], 'quicksorter',
+                    'quicksorter_counted',
+                    ['copy', 'quick', 'iter', 'merge'],
+                    ['-p', '-b', '-f']),
+}
+
+# algorithms that take O(n^2) time on some or all inputs
+QUADRATIC = {'minimum', 'bubble', 'insertion', 'copy', 'quick'}
+
+DISTRIBUTIONS = ['random', 'sorted', 'reversed', 'few-unique', 'organ-pipe',
+                 'sawtooth']
+
+INT_MIN, INT_MAX = -2**31, 2**31 - 1
+
+
+def generate(distribution, n, seed):
+    '''Return a list of n ints drawn from the named distribution.'''
+    rng = random.Random(seed)
+    if distribution == 'random':
+        return [rng.randint(INT_MIN, INT_MAX) for _ in range(n)]
+    if distribution == 'sorted':
+        return list(range(n))
+    if distribution == 'reversed':
+        return list(range(n, 0, -1))
+    if distribution == 'few-unique':
+        return [rng.randrange(16) for _ in range(n)]
+    if distribution == 'organ-pipe':
+        return [i if i < n // 2 else n - i for i in range(n)]
+    if distribution == 'sawtooth':
+        # 16 ascending runs
+        tooth = max(1, n // 16)
+        return [i % tooth for i in range(n)]
+    raise ValueError(distribution)
+
+
+def build(directory, targets, simd):
+    '''
+    Build the make targets; return an error message, or None.  Everything
+    is rebuilt, since make doesn't notice when only SIMDFLAGS changes.
+    '''
+    cmd = ['make', '-B'] + targets
+    if simd:
+        cmd.append('SIMDFLAGS=-O2 -mavx2')
+    result = subprocess.run(cmd, cwd=directory, capture_output=True,
+                            text=True)
+    if result.returncode != 0:
+        return result.stdout + result.stderr
+    return None
+
+
+def run_sort(binary, algorithm, input_options, filename, timeout,
+             expected=None):
+    '''
+    Sort the file once.  Return (status, sort seconds, comparisons, moves);
+    the counts are None unless the binary reports them.  If 'expected' is
+    given the output is checked against it.
+    '''
+    cmd = [binary, '-t', '-a', algorithm] + input_options + [filename]
+    if expected is None:
+        cmd.append('-q')
+    try:
+        result = subprocess.run(cmd, capture_output=True, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        return 'timeout', None, None, None
+    if result.returncode != 0:
+        return 'crashed ({})'.format(result.returncode), None, None, None
+    stderr = result.stderr.decode()
+    m = re.search(r'sort ([0-9.]+) s', stderr)
+    if m is None:
+        return 'no timing', None, None, None
+    seconds = float(m.group(1))
+    m = re.search(r'(\d+) comparisons, (\d+) moves', stderr)
+    comparisons, moves = (int(m.group(1)), int(m.group(2))) if m else \
+        (None, None)
+    if expected is not None and \
+            list(map(int, result.stdout.split())) != expected:
+        return 'wrong output', seconds, comparisons, moves
+    return 'ok', seconds, comparisons, moves
+
+
+def run(args):
+    programs = args.programs.split(',')
+    sizes = [int(s) for s in args.sizes.split(',')]
+    distributions = args.distributions.split(',')
+    for d in distributions:
+        if d not in DISTRIBUTIONS:
+            sys.exit('unknown distribution: ' + d)
+
+    if not args.no_build:
+        for name in programs:
+            directory, targets = PROGRAMS[name][:2]
+            error = build(directory, targets, args.simd)
+            if error:
+                sys.exit('building {} failed:\n{}'.format(name, error))
+
+    results = []
+    print('{:<12} {:<10} {:<11} {:>10} {:>12} {:>14} {:>14}'.format(
+        'program', 'algorithm', 'input', 'n', 'ns/element', 'comparisons',
+        'moves'))
+    with tempfile.TemporaryDirectory() as tmp:
+        for size in sizes:
+            for distribution in distributions:
+                data = generate(distribution, size, args.seed)
+                filename = os.path.join(tmp, 'input.bin')
+                with open(filename, 'wb') as f:
+                    array.array('i', data).tofile(f)
+                expected = sorted(data) if size <= args.verify_max else None
+                for name in programs:
+                    directory, _, binary, counted, algorithms, input_options \
+                        = PROGRAMS[name]
+                    for algorithm in algorithms:
+                        entry = {'program': name, 'algorithm': algorithm,
+                                 'distribution': distribution, 'size': size,
+                                 'status': 'ok', 'seconds': None,
+                                 'ns_per_element': None,
+                                 'comparisons': None, 'moves': None}
+                        if algorithm in QUADRATIC and size > args.quadratic_max:
+                            entry['status'] = 'skipped'
+                        else:
+                            best = None
+                            for r in range(args.repeat):
+                                status, seconds, _, _ = run_sort(
+                                    os.path.join(directory, binary), algorithm,
+                                    input_options, filename, args.timeout,
+                                    expected if r == 0 else None)
+                                if status != 'ok':
+                                    entry['status'] = status
+                                    break
+                                best = seconds if best is None \
+                                    else min(best, seconds)
+                            if entry['status'] == 'ok':
+                                entry['seconds'] = best
+                                entry['ns_per_element'] = best * 1e9 / size
+                                status, _, comparisons, moves = run_sort(
+                                    os.path.join(directory, counted),
+                                    algorithm, input_options, filename,
+                                    args.timeout)
+                                if status == 'ok':
+                                    entry['comparisons'] = comparisons
+                                    entry['moves'] = moves
+                        results.append(entry)
+                        show(entry)
+
+    output = {
+        'meta': {
+            'label': args.label,
+            'date': time.strftime('%Y-%m-%d %H:%M:%S'),
+            'commit': git_commit(),
+            'machine': platform.machine(),
+            'processor': platform.processor(),
+            'cpus': os.cpu_count(),
+            'simd': args.simd,
+            'repeat': args.repeat,
+            'seed': args.seed,
+        },
+        'results': results,
+    }
+    with open(args.output, 'w') as f:
+        json.dump(output, f, indent=1)
+    print('results written to', args.output)
+
+
+def show(entry):
+    def fmt(value, spec):
+        return '-' if value is None else format(value, spec)
+    line = '{:<12} {:<10} {:<11} {:>10} {:>12} {:>14} {:>14}'.format(
+        entry['program'], entry['algorithm'], entry['distribution'],
+        entry['size'], fmt(entry['ns_per_element'], '.2f'),
+        fmt(entry['comparisons'], 'd'), fmt(entry['moves'], 'd'))
+    if entry['status'] != 'ok':
+        line += '  ' + entry['status']
+    print(line)
+    sys.stdout.flush()
+
+
+def git_commit():
+    result = subprocess.run(['git', 'rev-parse', '--short', 'HEAD'],
+                            cwd=HERE, capture_output=True, text=True)
+    return result.stdout.strip() if result.returncode == 0 else None
+
+
+def compare(args):
+    def load(filename):
+        with open(filename) as f:
+            data = json.load(f)
+        return data['meta'], {(e['program'], e['algorithm'],
+                               e['distribution'], e['size']): e
+                              for e in data['results']}
+
+    old_meta, old = load(args.old)
+    new_meta, new = load(args.new)
+    print('old: {} ({})'.format(old_meta.get('label') or args.old,
+                                old_meta.get('commit')))
+    print('new: {} ({})'.format(new_meta.get('label') or args.new,
+                                new_meta.get('commit')))
+    print('{:<12} {:<10} {:<11} {:>10} {:>10} {:>10} {:>8}'.format(
+        'program', 'algorithm', 'input', 'n', 'old ns/el', 'new ns/el',
+        'change'))
+    regressions = 0
+    for key in sorted(set(old) & set(new)):
+        a, b = old[key]['ns_per_element'], new[key]['ns_per_element']
+        if a is None or b is None:
+            continue
+        change = b / a - 1
+        flag = ''
+        if change > args.threshold:
+            flag = '  slower'
+            regressions += 1
+        elif change < -args.threshold:
+            flag = '  faster'
+        if old[key]['comparisons'] != new[key]['comparisons']:
+            flag += '  comparisons {} -> {}'.format(old[key]['comparisons'],
+                                                   new[key]['comparisons'])
+        print('{:<12} {:<10} {:<11} {:>10} {:>10.2f} {:>10.2f} {:>+7.1f}%{}'
+              .format(*key, a, b, change * 100, flag))
+    print('{} of {} results more than {:.0f}% slower'.format(
+        regressions, len(set(old) & set(new)), args.threshold * 100))
+    sys.exit(1 if regressions else 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Sorting benchmark suite.')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('run', help='run the benchmarks')
+    p.add_argument('--programs', default='sorter,quicksorter',
+                   help='comma-separated programs (default: both)')
+    p.add_argument('--sizes', default='1000,100000,1000000',
+                   help='comma-separated input sizes')
+    p.add_argument('--distributions', default=','.join(DISTRIBUTIONS),
+                   help='comma-separated distributions, from: ' +
+                   ', '.join(DISTRIBUTIONS))
+    p.add_argument('--repeat', type=int, default=3,
+                   help='timed runs per case; the best is kept')
+    p.add_argument('--quadratic-max', type=int, default=10000,
+                   help='largest input for the O(n^2) algorithms')
+    p.add_argument('--verify-max', type=int, default=100000,
+                   help='largest input whose output is checked')
+    p.add_argument('--timeout', type=float, default=120,
+                   help='seconds before a run is abandoned')
+    p.add_argument('--seed', type=int, default=1)
+    p.add_argument('--simd', action='store_true',
+                   help='build with SIMDFLAGS="-O2 -mavx2"')
+    p.add_argument('--no-build', action='store_true',
+                   help="use the binaries as they are instead of running make")
+    p.add_argument('--label', default=None, help='name for this build')
+    p.add_argument('--output', '-o', default='sort_benchmark.json')
+    p.set_defaults(func=run)
+
+    p = sub.add_parser('compare', help='compare two result files')
+    p.add_argument('old')
+    p.add_argument('new')
+    p.add_argument('--threshold', type=float, default=0.10,
+                   help='relative change reported as slower/faster')
+    p.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,195 +1,424 @@
 /*
-This file sorts any group of numbers presented as command arguments as long as
-there are 32 or fewer number arguments. It defaults to a minimum element sort,
-but the optional command argument "-b" will make it sort using a bubble sort.
-The only other optional command argument is "-q", and this will suppress the
-printing of the sorted list.
+This file sorts any group of numbers presented as command arguments, read from
+a file or stdin, or generated at random; there is no limit on how many. It
+defaults to a minimum element sort, but the optional command arguments choose
+another algorithm:
+
+  -b         bubble sort
+  -a NAME    NAME is one of minimum, bubble, insertion, heap, intro, radix
+             or parallel (see sorts.h and parallel_sort.h)
+  -p         parallel merge sort, the same as "-a parallel"
+  -j N       use N threads for the parallel sort (default: every processor)
+
+and where the numbers come from:
+
+  -f FILE    also read numbers from FILE ("-" for stdin), as whitespace
+             separated text, or as native int32 records with -B
+  -B         read -f input as binary
+  -r N       also sort N pseudo-random numbers (fixed seed)
+
+"-e" sorts the -f input with an external merge sort instead (see
+external_sort.h), for inputs too big to fit in memory; nothing else may be
+given to sort. It uses about MB megabytes ("-M MB", default 256) and keeps
+its sorted runs in temporary files in DIR ("-T DIR", default the system
+temporary directory). With -B the output is binary int32 records too.
+
+"-t" prints the time taken to read, sort and print to stderr, followed by the
+number of comparisons and moves in builds with -DSORT_COUNTERS; with -e it
+prints the time spent forming and merging runs, the number of runs and merge
+passes, and the throughput in MB/s. The only other optional command argument
+is "-q", and this will suppress the printing of the sorted list.
 */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <string.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
-#include <assert.h>
-#define MAXVALUES 32
+#include <time.h>
+#include "sorts.h"
+#include "parallel_sort.h"
+#include "external_sort.h"
+#include "int_io.h"
+#include "sort_counters.h"
+
+/* the number buffer starts this big and doubles whenever it fills up */
+#define INITIAL_VALUES 32
 
-void minimum_entry_sort(int nums[], int argc);
-void bubble_sort(int nums[], int len);
+/*
+a growable buffer of numbers
+*/
+typedef struct
+{
+  int *nums;
+  long count;
+  long size;
+} num_buffer;
+
+void add_number(num_buffer *buf, int value);
+void read_numbers(num_buffer *buf, char *filename, int binary);
+void print_numbers(num_buffer *buf);
+void external(char *filename, int binary, long megabytes, char *tmpdir,
+              int q, int t);
+void usage(char *progname);
+double now(void);
 
 int main(int argc, char *argv[])
 {
-  int i, b, q, count, nums[MAXVALUES];
+  int i, q, t, binary, threads, extern_sort;
+  long nrandom, megabytes;
+  char *algorithm, *filename, *tmpdir;
+  double start, read_time, sort_time;
+  num_buffer buf;
   /* Checking to make sure a commandline argument was passed */
   if (argc == 1)
   {
-    fprintf(stderr, "usage: %s [-b] [-q] number1 [number2 ... ]"
-            " (maximum 32 numbers)\n", argv[0]);
-    exit(1);
+    usage(argv[0]);
   }
-  b = 0;
   q = 0;
-  count = 0;
+  t = 0;
+  binary = 0;
+  threads = 0;
+  nrandom = 0;
+  extern_sort = 0;
+  megabytes = EXTERNAL_DEFAULT_MB;
+  tmpdir = NULL;
+  algorithm = "minimum";
+  filename = NULL;
+  buf.nums = NULL;
+  buf.count = 0;
+  buf.size = 0;
+  start = now();
   /*
-  Looping through each element and adding to an array if int, or noting
-  whether -b or -q has been read using b and q variables
+  Looping through each element and adding to the buffer if int, or noting
+  which option has been read
   */
   for (i = 1; i < argc; i++)
   {
     if (strcmp(argv[i], "-b") == 0)
     {
-      b = 1;
+      algorithm = "bubble";
+    }
+    else if (strcmp(argv[i], "-p") == 0)
+    {
+      algorithm = "parallel";
     }
     else if (strcmp(argv[i], "-q") == 0)
     {
       q = 1;
     }
-    else
+    else if (strcmp(argv[i], "-t") == 0)
+    {
+      t = 1;
+    }
+    else if (strcmp(argv[i], "-B") == 0)
+    {
+      binary = 1;
+    }
+    else if (strcmp(argv[i], "-e") == 0)
     {
-      nums[count] = atoi(argv[i]);
-      count += 1;
-      if (count > 32)
+      extern_sort = 1;
+    }
+    else if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "-f") == 0
+             || strcmp(argv[i], "-T") == 0)
+    {
+      if (i + 1 == argc)
+      {
+        usage(argv[0]);
+      }
+      if (argv[i][1] == 'a')
+      {
+        algorithm = argv[++i];
+      }
+      else if (argv[i][1] == 'f')
+      {
+        filename = argv[++i];
+      }
+      else
+      {
+        tmpdir = argv[++i];
+      }
+    }
+    else if (strcmp(argv[i], "-M") == 0)
+    {
+      /* strtol saturates instead of overflowing; megabytes << 20 must fit */
+      if (i + 1 == argc || (megabytes = strtol(argv[i + 1], NULL, 10)) <= 0
+          || megabytes > (LONG_MAX >> 20))
       {
-        /* return an error if too many ints passed */
-        fprintf(stderr, "usage: %s [-b] [-q] number1 [number2 ... ]"
-                " (maximum 32 numbers)\n", argv[0]);
-        exit(1);
+        usage(argv[0]);
       }
+      i++;
+    }
+    else if (strcmp(argv[i], "-j") == 0)
+    {
+      if (i + 1 == argc || (threads = atoi(argv[i + 1])) <= 0)
+      {
+        usage(argv[0]);
+      }
+      i++;
+    }
+    else if (strcmp(argv[i], "-r") == 0)
+    {
+      if (i + 1 == argc || (nrandom = atol(argv[i + 1])) <= 0)
+      {
+        usage(argv[0]);
+      }
+      i++;
+    }
+    else
+    {
+      add_number(&buf, atoi(argv[i]));
     }
   }
-  /* return an error if no ints passed */
-  if (count == 0)
+  if (strcmp(algorithm, "minimum") != 0 && strcmp(algorithm, "bubble") != 0
+      && strcmp(algorithm, "insertion") != 0
+      && strcmp(algorithm, "heap") != 0 && strcmp(algorithm, "intro") != 0
+      && strcmp(algorithm, "radix") != 0
+      && strcmp(algorithm, "parallel") != 0)
   {
-    fprintf(stderr, "usage: %s [-b] [-q] number1 [number2 ... ]"
-            " (maximum 32 numbers)\n", argv[0]);
-    exit(1);
+    usage(argv[0]);
   }
-  /* minimum_entry_sort if no -b args */
-  if (b == 0)
+  /* the external sort streams the file, so there must be nothing else */
+  if (extern_sort)
   {
-    minimum_entry_sort(nums, count);
+    if (filename == NULL || buf.count > 0 || nrandom > 0)
+    {
+      usage(argv[0]);
+    }
+    external(filename, binary, megabytes, tmpdir, q, t);
+    return 0;
   }
-  /* bubble_sort if -b arg found */
-  else if (b == 1)
+  /* read the numbers from a file or stdin if asked to */
+  if (filename != NULL)
   {
-    bubble_sort(nums, count);
+    read_numbers(&buf, filename, binary);
   }
-  /* print results of sorting only if no -q args */
-  if (q == 0)
+  /* generate the random numbers if asked to */
+  if (nrandom > 0)
   {
-    for (i = 0; i < count; i++)
+    srand(1);
+    for (; nrandom > 0; nrandom--)
     {
-      fprintf(stdout, "%d\n", nums[i]);
+      add_number(&buf, rand());
     }
   }
+  /* return an error if no ints passed (an empty file is fine) */
+  if (buf.count == 0 && filename == NULL)
+  {
+    usage(argv[0]);
+  }
+  read_time = now() - start;
+  start = now();
+  if (strcmp(algorithm, "parallel") == 0)
+  {
+    parallel_sort(buf.nums, buf.count, threads);
+  }
+  else if (strcmp(algorithm, "bubble") == 0)
+  {
+    bubble_sort(buf.nums, buf.count);
+  }
+  else if (strcmp(algorithm, "insertion") == 0)
+  {
+    insertion_sort(buf.nums, buf.count);
+  }
+  else if (strcmp(algorithm, "heap") == 0)
+  {
+    heap_sort(buf.nums, buf.count);
+  }
+  else if (strcmp(algorithm, "intro") == 0)
+  {
+    introsort(buf.nums, buf.count);
+  }
+  else if (strcmp(algorithm, "radix") == 0)
+  {
+    radix_sort(buf.nums, buf.count);
+  }
+  else
+  {
+    minimum_entry_sort(buf.nums, buf.count);
+  }
+  sort_time = now() - start;
+  /* print results of sorting only if no -q args */
+  start = now();
+  if (q == 0)
+  {
+    print_numbers(&buf);
+  }
+  if (t == 1)
+  {
+    fprintf(stderr, "%ld values: read %.6f s, sort %.6f s, print %.6f s\n",
+            buf.count, read_time, sort_time, now() - start);
+#ifdef SORT_COUNTERS
+    fprintf(stderr, "%lu comparisons, %lu moves\n", sort_comparisons,
+            sort_moves);
+#endif
+  }
+  free(buf.nums);
   return 0;
 }
 
 /*
-minimum_entry_sort is a function that sorts an array of ints from least
-to greatest using the minimum entry sort method, and then it will print the
-integers to the terminal in this order.
-
-Arguments:
-
-nums[] --> the integer array containing the numbers to be sorted
-len --> the number of integers in the integer array
-
-Return:
-
-void
-
-Note: The minimum entry sort method is done by swapping the least member of an
-      array with the first member, then swapping the least member of the rest
-      of the array with the second member, etc.
+add_number adds a number to the end of the buffer, doubling its size first if
+it is full
 */
 
-void minimum_entry_sort(int nums[], int len)
+void add_number(num_buffer *buf, int value)
 {
-  /*
-  Variables:
+  int *bigger;
+  if (buf->count == buf->size)
+  {
+    buf->size = (buf->size == 0) ? INITIAL_VALUES : 2 * buf->size;
+    bigger = (int *)realloc(buf->nums, buf->size * sizeof(int));
+    if (bigger == NULL)
+    {
+      fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+      exit(1);
+    }
+    buf->nums = bigger;
+  }
+  buf->nums[buf->count++] = value;
+}
 
-  i --> an index varible used to loop through each position in the array
+/*
+read_numbers adds the numbers in the named file (or stdin for "-") to the
+buffer, exiting with an error message if the file can't be read or holds a
+bad number
+*/
 
-  n --> an index varibale used to compare every position with position i
+void read_numbers(num_buffer *buf, char *filename, int binary)
+{
+  FILE *fp;
+  int_reader *reader;
+  int value, status;
+  if (strcmp(filename, "-") == 0)
+  {
+    fp = stdin;
+  }
+  else if ((fp = fopen(filename, binary ? "rb" : "r")) == NULL)
+  {
+    fprintf(stderr, "Error: can't open %s\n", filename);
+    exit(1);
+  }
+  /* the reader's buffer is too big to put on the stack */
+  reader = (int_reader *)malloc(sizeof(int_reader));
+  if (reader == NULL)
+  {
+    fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+    exit(1);
+  }
+  int_reader_init(reader, fp, binary);
+  while ((status = int_reader_next(reader, &value)) == 1)
+  {
+    add_number(buf, value);
+  }
+  if (status == -1)
+  {
+    exit(1);
+  }
+  free(reader);
+  if (fp != stdin)
+  {
+    fclose(fp);
+  }
+}
 
-  temp --> a temporary storage necessary to swap two positions in an array
+/*
+print_numbers prints the numbers in the buffer, one per line, through a
+buffered writer rather than one fprintf per number
+*/
 
-  min --> a marker that denotes the minimum index in the arry
-  */
-  int i, n, temp, min;
-  /*
-  the function remembers the smallest index, then loops through and swaps
-  positions every time a smalller number is read
-  */
-  for (i = 0; i < len; i++)
+void print_numbers(num_buffer *buf)
+{
+  int_writer *writer;
+  long i;
+  writer = (int_writer *)malloc(sizeof(int_writer));
+  if (writer == NULL)
   {
-    min = i;
-    for (n = i; n < len; n++)
+    fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+    exit(1);
+  }
+  int_writer_init(writer, stdout);
+  for (i = 0; i < buf->count; i++)
+  {
+    if (int_writer_put(writer, buf->nums[i]) == -1)
     {
-      if (nums[min] > nums[n])
-      {
-        min = n;
-      }
+      exit(1);
     }
-    temp = nums[i];
-    nums[i] = nums[min];
-    nums[min] = temp;
   }
-  /* assert the sort has worked properly */
-  for (i = 1; i < len; i++)
+  if (int_writer_flush(writer) == -1 || fflush(stdout) != 0)
   {
-    assert(nums[i] >= nums[i-1]);
+    exit(1);
   }
+  free(writer);
 }
 
 /*
-print_bubble_sort is a function that sorts an array of ints from least
-to greatest using the bubble sort method, and then it will print the
-integers to the terminal in this order.
-
-Arguments:
-
-nums[] --> the integer array containing the numbers to be sorted
-
-len --> the number of integers in the integer array
-
-Return:
-
-void
-
+external sorts the named file (or stdin for "-") with external_sort, writing
+the result to stdout unless q is set and reporting on it if t is set; it
+exits with an error message if anything goes wrong
 */
 
-void bubble_sort(int nums[], int len)
+void external(char *filename, int binary, long megabytes, char *tmpdir,
+              int q, int t)
 {
-  /*
-  Variables:
-
-  i --> an index varible used to run the bubble sort on each pair at least len
-        number of times
-  n --> an index varibale used to compare every adjacent pair of values in the
-        array
-  temp --> a temporary storage necessary to swap two positions in an array
-  */
-  int i, n, temp;
-  /*
-  the function compares adjacent entries and swaps them if the right one is
-  larger than the left one. This is done len number of times to ensure sorting
-  */
-  for (i = 0; i < len - 1; i++)
+  FILE *fp;
+  external_stats stats;
+  double seconds;
+  if (strcmp(filename, "-") == 0)
   {
-    for (n = 0; n < len - 1; n++)
-    {
-      if (nums[n] > nums[n + 1])
-      {
-        temp = nums[n];
-        nums[n] = nums[n + 1];
-        nums[n + 1] = temp;
-      }
-    }
+    fp = stdin;
+  }
+  else if ((fp = fopen(filename, binary ? "rb" : "r")) == NULL)
+  {
+    fprintf(stderr, "Error: can't open %s\n", filename);
+    exit(1);
   }
-  /* assert sorting has been done properly */
-  for (i = 1; i < len; i++)
+  if (external_sort(fp, binary, q ? NULL : stdout, binary, megabytes << 20,
+                    tmpdir, &stats) == -1 || fflush(stdout) != 0)
   {
-    assert(nums[i] >= nums[i-1]);
+    exit(1);
   }
+  if (fp != stdin)
+  {
+    fclose(fp);
+  }
+  if (t == 1)
+  {
+    seconds = stats.run_seconds + stats.merge_seconds;
+    fprintf(stderr, "%ld values: runs %.6f s, merge %.6f s, %ld runs, "
+            "%d merge passes, %ld MB spilled, %.1f MB/s\n", stats.values,
+            stats.run_seconds, stats.merge_seconds, stats.runs, stats.passes,
+            stats.spilled >> 20, (seconds > 0) ?
+            stats.values * sizeof(int) / seconds / (1 << 20) : 0.0);
+#ifdef SORT_COUNTERS
+    fprintf(stderr, "%lu comparisons, %lu moves\n", sort_comparisons,
+            sort_moves);
+#endif
+  }
+}
+
+/*
+usage prints the command syntax and exits
+*/
+
+void usage(char *progname)
+{
+  fprintf(stderr, "usage: %s [-b | -p [-j threads] | -a algorithm] [-q] "
+          "[-t] [-f file [-B]] [-r N] [number1 ... ]\n"
+          "       %s -e -f file [-B] [-M MB] [-T dir] [-q] [-t]\n", progname,
+          progname);
+  exit(1);
+}
+
+/*
+now returns the current wall-clock time in seconds
+*/
+
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
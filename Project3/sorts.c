@@ -0,0 +1,456 @@
+/*
+This file implements the array sorts declared in sorts.h.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sorts.h"
+#include "small_sort.h"
+#include "sort_counters.h"
+
+#ifdef SORT_COUNTERS
+unsigned long sort_comparisons = 0;
+unsigned long sort_moves = 0;
+#endif
+
+#define RADIX_SIZE   (1 << RADIX_BITS)
+#define RADIX_PASSES (32 / RADIX_BITS)
+
+/*
+minimum_entry_sort is a function that sorts an array of ints from least
+to greatest using the minimum entry sort method.
+
+Arguments:
+
+nums[] --> the integer array containing the numbers to be sorted
+len --> the number of integers in the integer array
+
+Return:
+
+void
+
+Note: The minimum entry sort method is done by swapping the least member of an
+      array with the first member, then swapping the least member of the rest
+      of the array with the second member, etc.
+*/
+
+void minimum_entry_sort(int nums[], long len)
+{
+  /*
+  Variables:
+
+  i --> an index varible used to loop through each position in the array
+
+  n --> an index varibale used to compare every position with position i
+
+  temp --> a temporary storage necessary to swap two positions in an array
+
+  min --> a marker that denotes the minimum index in the arry
+  */
+  long i, n, min;
+  int temp;
+  /*
+  the function remembers the smallest index, then loops through and swaps
+  positions every time a smalller number is read
+  */
+  for (i = 0; i < len; i++)
+  {
+    min = i;
+    for (n = i; n < len; n++)
+    {
+      if (LESS(nums[n], nums[min]))
+      {
+        min = n;
+      }
+    }
+    temp = nums[i];
+    nums[i] = nums[min];
+    nums[min] = temp;
+    COUNT_MOVES(2);
+  }
+  /* assert the sort has worked properly */
+  for (i = 1; i < len; i++)
+  {
+    assert(nums[i] >= nums[i-1]);
+  }
+}
+
+/*
+bubble_sort is a function that sorts an array of ints from least to greatest
+using the bubble sort method.
+
+Arguments:
+
+nums[] --> the integer array containing the numbers to be sorted
+
+len --> the number of integers in the integer array
+
+Return:
+
+void
+
+*/
+
+void bubble_sort(int nums[], long len)
+{
+  /*
+  Variables:
+
+  i --> an index varible used to run the bubble sort on each pair at least len
+        number of times
+  n --> an index varibale used to compare every adjacent pair of values in the
+        array
+  temp --> a temporary storage necessary to swap two positions in an array
+  */
+  long i, n;
+  int temp;
+  /*
+  the function compares adjacent entries and swaps them if the right one is
+  larger than the left one. This is done len number of times to ensure sorting
+  */
+  for (i = 0; i < len - 1; i++)
+  {
+    for (n = 0; n < len - 1; n++)
+    {
+      if (LESS(nums[n + 1], nums[n]))
+      {
+        temp = nums[n];
+        nums[n] = nums[n + 1];
+        nums[n + 1] = temp;
+        COUNT_MOVES(2);
+      }
+    }
+  }
+  /* assert sorting has been done properly */
+  for (i = 1; i < len; i++)
+  {
+    assert(nums[i] >= nums[i-1]);
+  }
+}
+
+/*
+insertion_sort is a function that sorts an array of ints from least to
+greatest using the insertion sort method.
+
+Arguments:
+
+nums[] --> the integer array containing the numbers to be sorted
+
+len --> the number of integers in the integer array
+
+Return:
+
+void
+
+Note: Each value in turn is moved left past all the larger values before it,
+      so the part of the array to its left is always sorted.
+*/
+
+void insertion_sort(int nums[], long len)
+{
+  long i, n;
+  int value;
+  for (i = 1; i < len; i++)
+  {
+    value = nums[i];
+    for (n = i; n > 0 && LESS(value, nums[n - 1]); n--)
+    {
+      nums[n] = nums[n - 1];
+      COUNT_MOVES(1);
+    }
+    nums[n] = value;
+    COUNT_MOVES(1);
+  }
+}
+
+/*
+sift_down restores the max-heap order of nums[0..len-1] below position i,
+assuming both of i's subtrees are already heaps
+*/
+
+static void sift_down(int nums[], long i, long len)
+{
+  long child;
+  int value = nums[i];
+  while ((child = 2 * i + 1) < len)
+  {
+    if (child + 1 < len && LESS(nums[child], nums[child + 1]))
+    {
+      child++;
+    }
+    if (!LESS(value, nums[child]))
+    {
+      break;
+    }
+    nums[i] = nums[child];
+    COUNT_MOVES(1);
+    i = child;
+  }
+  nums[i] = value;
+  COUNT_MOVES(1);
+}
+
+/*
+heap_sort is a function that sorts an array of ints from least to greatest
+using the heap sort method.
+
+Arguments:
+
+nums[] --> the integer array containing the numbers to be sorted
+
+len --> the number of integers in the integer array
+
+Return:
+
+void
+
+Note: The array is first rearranged into a max-heap; then the largest value
+      is repeatedly swapped to the end and the heap shrunk by one.
+*/
+
+void heap_sort(int nums[], long len)
+{
+  long i;
+  int temp;
+  for (i = len / 2 - 1; i >= 0; i--)
+  {
+    sift_down(nums, i, len);
+  }
+  for (i = len - 1; i > 0; i--)
+  {
+    temp = nums[0];
+    nums[0] = nums[i];
+    nums[i] = temp;
+    COUNT_MOVES(2);
+    sift_down(nums, 0, i);
+  }
+}
+
+/*
+median_of_three returns the median of the values a quarter, half and three
+quarters of the way through nums[0..len-1]. Unlike the first, middle and last
+values, these aren't all at a peak or trough of organ-pipe shaped input.
+*/
+
+static int median_of_three(int nums[], long len)
+{
+  int a = nums[len / 4], b = nums[len / 2], c = nums[len - 1 - len / 4];
+  COUNT_COMPARISONS(3);
+  if (a > b)
+  {
+    int temp = a;
+    a = b;
+    b = temp;
+  }
+  if (b > c)
+  {
+    b = c;
+  }
+  return (a > b) ? a : b;
+}
+
+/*
+introsort_loop quicksorts nums[0..len-1] down to partitions of
+small_sort_cutoff values, which it finishes with small_sort if that has a
+sorting network and otherwise leaves unsorted, and heap sorts any partition
+reached after depth_limit levels. It recurses on the smaller side of each
+partition and loops on the larger one, so the stack stays O(log n).
+*/
+
+static void introsort_loop(int nums[], long len, int depth_limit)
+{
+  long i, j;
+  int pivot, temp;
+  while (len > small_sort_cutoff)
+  {
+    if (depth_limit-- == 0)
+    {
+      heap_sort(nums, len);
+      return;
+    }
+    /*
+    Hoare partition: afterwards nums[0..j] <= pivot <= nums[j+1..len-1],
+    and both sides are non-empty because the pivot is one of the values
+    */
+    pivot = median_of_three(nums, len);
+    i = -1;
+    j = len;
+    for (;;)
+    {
+      do
+      {
+        i++;
+      } while (LESS(nums[i], pivot));
+      do
+      {
+        j--;
+      } while (LESS(pivot, nums[j]));
+      if (i >= j)
+      {
+        break;
+      }
+      temp = nums[i];
+      nums[i] = nums[j];
+      nums[j] = temp;
+      COUNT_MOVES(2);
+    }
+    if (j + 1 < len - j - 1)
+    {
+      introsort_loop(nums, j + 1, depth_limit);
+      nums += j + 1;
+      len -= j + 1;
+    }
+    else
+    {
+      introsort_loop(nums + j + 1, len - j - 1, depth_limit);
+      len = j + 1;
+    }
+  }
+  if (small_sort_network)
+  {
+    small_sort(nums, len);
+  }
+}
+
+/*
+introsort is a function that sorts an array of ints from least to greatest
+using the introsort method.
+
+Arguments:
+
+nums[] --> the integer array containing the numbers to be sorted
+
+len --> the number of integers in the integer array
+
+Return:
+
+void
+
+Note: Introsort is a median-of-three quicksort that gives up on a partition
+      and heap sorts it after 2 * log2(len) levels, which only happens on
+      adversarial inputs. Partitions of small_sort_cutoff or fewer values are
+      sorted with small_sort's network when it is compiled in (see
+      small_sort.h). Otherwise they are left alone, and one insertion sort
+      over the whole array finishes them, since no value is more than
+      small_sort_cutoff places out; that beats a call per partition.
+*/
+
+void introsort(int nums[], long len)
+{
+  int depth_limit = 0;
+  long n;
+  for (n = len; n > 1; n /= 2)
+  {
+    depth_limit += 2;
+  }
+  introsort_loop(nums, len, depth_limit);
+  if (!small_sort_network)
+  {
+    insertion_sort(nums, len);
+  }
+}
+
+/*
+radix_key maps an int to an unsigned key with the same order: flipping the
+sign bit puts the negative numbers below the positive ones
+*/
+
+static unsigned long radix_key(int value)
+{
+  return ((unsigned long)(unsigned int)value ^ 0x80000000UL) & 0xffffffffUL;
+}
+
+/*
+radix_sort is a function that sorts an array of ints from least to greatest
+using the least significant digit radix sort method.
+
+Arguments:
+
+nums[] --> the integer array containing the numbers to be sorted
+
+len --> the number of integers in the integer array
+
+Return:
+
+void
+
+Note: Each pass stably distributes the values by one RADIX_BITS-bit digit of
+      their key, from the lowest digit to the highest, moving them between
+      nums and a scratch array. The counts for every digit are gathered in a
+      single read of the array before the first pass, and a pass is skipped
+      when all the values share the same digit, which is common with skewed
+      or narrow-ranged input.
+*/
+
+void radix_sort(int nums[], long len)
+{
+  long counts[RADIX_PASSES][RADIX_SIZE];
+  long i, offset, next;
+  int pass, digit, shift, skipped;
+  int *src = nums, *dst, *tmp, *swap;
+  unsigned long key;
+  if (len < 2)
+  {
+    return;
+  }
+  tmp = (int *)malloc(len * sizeof(int));
+  if (tmp == NULL)
+  {
+    fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+    exit(1);
+  }
+  dst = tmp;
+  /* count every digit of every key in one pass over the data */
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < len; i++)
+  {
+    key = radix_key(nums[i]);
+    for (pass = 0; pass < RADIX_PASSES; pass++)
+    {
+      counts[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+    }
+  }
+  for (pass = 0; pass < RADIX_PASSES; pass++)
+  {
+    shift = pass * RADIX_BITS;
+    /* skip the pass if every value has the same digit here */
+    skipped = 0;
+    for (digit = 0; digit < RADIX_SIZE; digit++)
+    {
+      if (counts[pass][digit] == len)
+      {
+        skipped = 1;
+      }
+    }
+    if (skipped)
+    {
+      continue;
+    }
+    /* turn the counts into the starting position of each digit */
+    offset = 0;
+    for (digit = 0; digit < RADIX_SIZE; digit++)
+    {
+      next = offset + counts[pass][digit];
+      counts[pass][digit] = offset;
+      offset = next;
+    }
+    for (i = 0; i < len; i++)
+    {
+      digit = (int)((radix_key(src[i]) >> shift) & (RADIX_SIZE - 1));
+      dst[counts[pass][digit]++] = src[i];
+    }
+    COUNT_MOVES(len);
+    swap = src;
+    src = dst;
+    dst = swap;
+  }
+  /* an odd number of passes leaves the result in the scratch array */
+  if (src != nums)
+  {
+    memcpy(nums, src, len * sizeof(int));
+    COUNT_MOVES(len);
+  }
+  free(tmp);
+}
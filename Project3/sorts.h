@@ -0,0 +1,28 @@
+/*
+This file declares the array sorts used by sorter. Each one sorts
+nums[0..len-1] from least to greatest in place.
+
+minimum_entry_sort and bubble_sort are O(n^2) and only practical for small
+inputs. insertion_sort is O(n^2) too, but very fast on short or nearly sorted
+arrays. heap_sort is O(n log n) in the worst case. introsort is a quicksort
+that switches to heap_sort for any partition that recurses too deep, so it is
+O(n log n) in the worst case and usually the fastest comparison sort; it
+finishes short partitions with small_sort (see small_sort.h). radix_sort
+doesn't compare values at all: it is a least significant digit radix sort
+that is O(n) but needs a scratch array as big as the input.
+*/
+
+#ifndef SORTS_H
+#define SORTS_H
+
+/* radix_sort works on digits of this many bits (it must divide 32) */
+#define RADIX_BITS 8
+
+void minimum_entry_sort(int nums[], long len);
+void bubble_sort(int nums[], long len);
+void insertion_sort(int nums[], long len);
+void heap_sort(int nums[], long len);
+void introsort(int nums[], long len);
+void radix_sort(int nums[], long len);
+
+#endif
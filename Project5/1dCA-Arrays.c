@@ -9,55 +9,115 @@ the terminal using the transition rule:
 
 Full cells are indicated by '*' symbols and empty cells are indicated by '-'
 symbols
+
+The optional command argument "-q" suppresses the printing of the cells and
+prints the time taken and the cell updates per second to stderr instead,
+"-e N" prints only every Nth generation (the first, the N+1th, and so on), and
+"-s seed" seeds the random first generation (default: the time).
 */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include "memcheck.h"
 
 void initialize_board(int board[], int len);
 void board_update(int board[], int newboard[], int len);
-void print_cells(int board[], int len);
+void print_cells(int board[], char row[], int len);
+void usage(char *progname);
+double now(void);
 
 int main(int argc, char *argv[])
 {
-  int i, len, gens;
-  int *board, *newboard;;
-  /* Checking to make sure a commandline argument was passed */
-  if (argc < 3)
+  int i, len, gens, q, every, nargs;
+  unsigned int seed;
+  int *board, *newboard, *swap;
+  char *row;
+  char *args[2];
+  double start, seconds;
+  q = 0;
+  every = 1;
+  nargs = 0;
+  seed = (unsigned int)time(0);
+  for (i = 1; i < argc; i++)
   {
-    fprintf(stderr, "usage: %s population generations\n", argv[0]);
-    exit(1);
+    if (strcmp(argv[i], "-q") == 0)
+    {
+      q = 1;
+    }
+    else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+    {
+      every = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      seed = (unsigned int)atol(argv[++i]);
+    }
+    else if (nargs < 2)
+    {
+      args[nargs++] = argv[i];
+    }
+    else
+    {
+      usage(argv[0]);
+    }
+  }
+  /* Checking to make sure a population and generation count were passed */
+  if (nargs < 2)
+  {
+    usage(argv[0]);
   }
-  len = atoi(argv[1]);
-  gens = atoi(argv[2]);
-  srand(time(0));
+  len = atoi(args[0]);
+  gens = atoi(args[1]);
+  if (len < 1 || every < 1)
+  {
+    usage(argv[0]);
+  }
+  srand(seed);
+  /*
+  the two boards are allocated once and swapped after every generation: each
+  new generation is written over the one before last, so nothing is copied,
+  and the edge cells, never written, stay empty in both
+  */
   board = (int *) calloc(len, sizeof(int));
-  /* Check that the calloc call succeeded. */
-  if (board == NULL)
+  newboard = (int *) calloc(len, sizeof(int));
+  /* each row is built here, with its newline, and written in one go */
+  row = (char *) malloc(len + 1);
+  /* Check that the allocations succeeded. */
+  if (board == NULL || newboard == NULL || row == NULL)
   {
     fprintf(stderr, "Error! Memory allocation failed!\n");
     exit(1);  /* abort the program */
   }
   /* create the initial board */
   initialize_board(board, len);
+  start = now();
   for (i = 0; i < gens; i++)
   {
     /* turning a board into the visual cells, printing the cells, and then
     updating the board for each generation */
-    newboard = (int *) calloc(len, sizeof(int));
-    /* Check that the calloc call succeeded. */
-    if (newboard == NULL)
+    if (q == 0 && i % every == 0)
     {
-        fprintf(stderr, "Error! Memory allocation failed!\n");
-        exit(1);  /* abort the program */
+      print_cells(board, row, len);
     }
-    print_cells(board, len);
     board_update(board, newboard, len);
-    free(newboard);
+    swap = board;
+    board = newboard;
+    newboard = swap;
+  }
+  seconds = now() - start;
+  if (q == 1)
+  {
+    fprintf(stderr, "%d cells, %d generations: %.6f s, %.4g cell updates/s\n",
+            len, gens, seconds,
+            (seconds > 0) ? (double)len * gens / seconds : 0.0);
   }
   free(board);
+  free(newboard);
+  free(row);
   print_memory_leaks();
   return 0;
 }
@@ -80,8 +140,9 @@ void initialize_board(int board[], int len)
 }
 
 /*
-board_update is a function that creates a new board for the next generation
-based on the transition rule.
+board_update is a function that writes the next generation into newboard
+based on the transition rule. It leaves board alone; the caller swaps the two
+for the next generation.
 */
 void board_update(int board[], int newboard[], int len)
 {
@@ -108,31 +169,40 @@ void board_update(int board[], int newboard[], int len)
       newboard[i] = 0;
     }
   }
-  /* we modify our acting board to match the one used to store the new gen */
-  for (i = 0; i < len; i++)
-  {
-    board[i] = newboard[i];
-  }
 }
 
 /*
-create_cells is a function that turns a board into a character array that
-represents the visual representation of the board_update
+print_cells is a function that turns a board into a row of characters in
+row[], which must have room for len + 1, and writes it with a single fwrite
 */
-void print_cells(int board[], int len)
+void print_cells(int board[], char row[], int len)
 {
   int i;
   for (i = 0; i < len; i++)
   {
     /* a 0 in board --> a - in cells; a 1 in board --> a * in cells */
-    if (board[i] == 0)
-    {
-      printf("-");
-    }
-    else
-    {
-      printf("*");
-    }
+    row[i] = (board[i] == 0) ? '-' : '*';
   }
-  printf("\n");
+  row[len] = '\n';
+  fwrite(row, 1, len + 1, stdout);
+}
+
+/*
+usage prints the command syntax and exits
+*/
+void usage(char *progname)
+{
+  fprintf(stderr, "usage: %s [-q] [-e N] [-s seed] population generations\n",
+          progname);
+  exit(1);
+}
+
+/*
+now returns the current wall-clock time in seconds
+*/
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
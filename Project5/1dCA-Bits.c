@@ -0,0 +1,872 @@
+/*
+This file creates a one dimensional cellular automaton that will be printed to
+the terminal. By default it uses the same transition rule as 1dCA-Arrays.c:
+
+1. If the current cell is empty, and one of the two adjacent cells is full
+   (but not both), set the current cell to be full.
+
+2. Otherwise set the current cell to be empty.
+
+which is elementary rule 18, but "-r N" chooses any of the 256 elementary
+rules, and "-t CODE" a totalistic rule, where a cell is full in the next
+generation if bit k of CODE is set, k being the number of full cells within
+"-R RADIUS" cells of it (itself included; the radius is 1 to 4, default 1).
+
+Full cells are indicated by '*' symbols and empty cells are indicated by '-'
+symbols. The first and last cells are always empty, as are the cells beyond
+them.
+
+Instead of an int per cell, the board packs 64 cells into each uint64_t, cell
+i being bit i % 64 of word i / 64. Rule 18 is then just
+
+  new = ~cell & (left ^ right)
+
+where "left" and "right" are the board shifted by one cell each way, so a
+whole word of cells is updated with a few shifts, an XOR and an AND-NOT. The
+other elementary rules are evaluated the same way from their algebraic normal
+form, an XOR of ANDs of left, cell and right worked out when the rule is
+chosen. Totalistic rules, which depend on more cells, use a lookup table
+instead: it maps every window of 8 + 2 * RADIUS cells to the next generation
+of the 8 cells in its middle, so each table lookup computes 8 cells. In
+builds with AVX2 ('make SIMDFLAGS="-O2 -mavx2"') the elementary rules update
+four words, 256 cells, per instruction.
+
+"-j N" splits the board into N tiles, one per thread. With "-k K" the
+generations run in blocks of K: each thread advances its tile K generations
+at a time, a cache-sized chunk at a time, working on a copy of the chunk
+widened by K words on each side, and the threads only wait for each other
+between blocks (see tile_thread); a block also ends at each generation that
+is printed. "-k" is worthwhile with one thread, too, on boards too big for
+the cache.
+
+"-e N" prints only every Nth generation (the first, the N+1th, and so on),
+and "-f FORMAT" chooses how: "text" (the default) prints a row of '-' and '*'
+per generation; "pbm" writes the space-time diagram as a binary PBM (P4)
+image, a row of pixels per generation, black for full cells; "raw" writes
+each generation as the board's words, native 64-bit integers with cell i in
+bit i % 64 of word i / 64, with no header.
+
+The other optional command arguments are "-q", which suppresses the printing
+of the cells and prints the time taken and the cell updates per second to
+stderr instead, "-s seed", which seeds the random first generation (default:
+the time), "-w", which uses the one-word-at-a-time update even in AVX2
+builds, and "-L", which uses a lookup table for elementary rules too; the
+last two are for comparison.
+*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "memcheck.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/* the number of cells in one word of the board */
+#define WORD_BITS 64
+
+/* the built-in rule, and the largest radius of a totalistic rule */
+#define DEFAULT_RULE 18
+#define MAX_RADIUS 4
+
+/*
+the tiled simulation works on chunks of this many words (256K cells), so the
+two copies of a chunk fit in a typical L2 cache
+*/
+#define CHUNK_WORDS 4096
+
+/*
+a packed board: words[-1] and words[nwords] are always zero, so the update
+can read one word past either end without checking for it
+*/
+typedef struct
+{
+  uint64_t *words;
+  long nwords;
+  long len;
+  uint64_t last_mask;  /* the cells of the last word that may be full */
+} bit_board;
+
+/*
+a transition rule: an elementary rule, evaluated from its algebraic normal
+form anf[] (anf[S] is all ones if the product of the cells in S is one of the
+terms, S having bit 2 for left, bit 1 for the cell and bit 0 for right), or a
+lookup table over windows of 8 + 2 * radius cells
+*/
+typedef struct
+{
+  int number;             /* the elementary rule, or -1 */
+  uint64_t anf[8];
+  int radius;
+  unsigned char *table;   /* NULL unless the rule uses a lookup table */
+} ca_rule;
+
+/* the ways generations can be written */
+#define FORMAT_TEXT 0
+#define FORMAT_PBM 1
+#define FORMAT_RAW 2
+
+/*
+how and how often generations are written to stdout; a text or PBM row is
+built in row and written with a single fwrite
+*/
+typedef struct
+{
+  int format;
+  long every;
+  char *row;
+  long row_bytes;
+  char chars[256][8];           /* the text for each byte of cells */
+  unsigned char reversed[256];  /* each byte with its bits reversed */
+} ca_output;
+
+/* what all the threads of a parallel simulation share */
+typedef struct
+{
+  const bit_board *board;
+  uint64_t *boards[2];    /* bases of the board and the spare board */
+  const ca_rule *rule;
+  long gens;
+  int depth;              /* generations per block, between barriers */
+  int nthreads;
+  int one_word;
+  ca_output *output;      /* NULL if nothing is written */
+  uint64_t *result;       /* base of the board with the last generation */
+  pthread_barrier_t barrier;
+} ca_job;
+
+/* what each thread is told, and its own two copies of its tile */
+typedef struct
+{
+  ca_job *job;
+  int id;
+  uint64_t *buffers[2];
+} ca_worker;
+
+void usage(char *progname);
+uint64_t *allocate_board(long nwords);
+void initialize_board(bit_board *board);
+void elementary_rule(ca_rule *rule, int number);
+void make_table(ca_rule *rule, long code, int radius);
+void board_update(const bit_board *board, uint64_t *next,
+                  const ca_rule *rule, int one_word);
+void update_range(const uint64_t *words, uint64_t *next, long from, long to,
+                  const ca_rule *rule, int one_word);
+void run_chunk(ca_worker *worker, const uint64_t *cur, uint64_t *spare,
+               long lo, long hi, int steps);
+void *tile_thread(void *arg);
+uint64_t *parallel_run(ca_job *job);
+void board_update_words(const uint64_t *words, uint64_t *next, long from,
+                        long to, const ca_rule *rule);
+void table_update_words(const uint64_t *words, uint64_t *next, long from,
+                        long to, const ca_rule *rule);
+void output_init(ca_output *out, const bit_board *board, int format,
+                 long every, long gens);
+void print_cells(ca_output *out, const bit_board *board);
+double now(void);
+
+int main(int argc, char *argv[])
+{
+  int i, q, format, one_word, use_table, radius, nargs, nthreads, depth;
+  long gens, g, number, code, every;
+  unsigned int seed;
+  uint64_t *base, *next, *swap;
+  bit_board board;
+  ca_rule rule;
+  ca_job job;
+  ca_output output;
+  double start, seconds;
+  char *args[2];
+  q = 0;
+  format = FORMAT_TEXT;
+  every = 1;
+  one_word = 0;
+  use_table = 0;
+  nthreads = 1;
+  depth = 1;
+  radius = 1;
+  number = DEFAULT_RULE;
+  code = -1;
+  nargs = 0;
+  seed = (unsigned int)time(0);
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-q") == 0)
+    {
+      q = 1;
+    }
+    else if (strcmp(argv[i], "-w") == 0)
+    {
+      one_word = 1;
+    }
+    else if (strcmp(argv[i], "-L") == 0)
+    {
+      use_table = 1;
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      seed = (unsigned int)atol(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      number = atol(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+    {
+      code = atol(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc)
+    {
+      radius = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+    {
+      every = atol(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+    {
+      i++;
+      if (strcmp(argv[i], "pbm") == 0)
+      {
+        format = FORMAT_PBM;
+      }
+      else if (strcmp(argv[i], "raw") == 0)
+      {
+        format = FORMAT_RAW;
+      }
+      else if (strcmp(argv[i], "text") != 0)
+      {
+        usage(argv[0]);
+      }
+    }
+    else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+    {
+      nthreads = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+    {
+      depth = atoi(argv[++i]);
+    }
+    else if (nargs < 2)
+    {
+      args[nargs++] = argv[i];
+    }
+    else
+    {
+      usage(argv[0]);
+    }
+  }
+  /* Checking to make sure a population and generation count were passed */
+  if (nargs < 2)
+  {
+    usage(argv[0]);
+  }
+  board.len = atol(args[0]);
+  gens = atol(args[1]);
+  if (board.len < 1 || gens < 0 || number < 0 || number > 255
+      || radius < 1 || radius > MAX_RADIUS
+      || code >= (1L << (2 * radius + 2)) || nthreads < 1 || depth < 1
+      || depth > CHUNK_WORDS || every < 1)
+  {
+    usage(argv[0]);
+  }
+  /* a totalistic code overrides the elementary rule */
+  elementary_rule(&rule, (code >= 0) ? -1 : (int)number);
+  if (code >= 0)
+  {
+    make_table(&rule, code, radius);
+  }
+  else if (use_table)
+  {
+    make_table(&rule, -1, 1);
+  }
+  srand(seed);
+  board.nwords = (board.len + WORD_BITS - 1) / WORD_BITS;
+  /* the cells past the end, and the last cell itself, stay empty */
+  board.last_mask = 0;
+  if ((board.len - 1) % WORD_BITS != 0)
+  {
+    board.last_mask = ~(uint64_t)0
+      >> (WORD_BITS - (board.len - 1) % WORD_BITS);
+  }
+  base = allocate_board(board.nwords);
+  next = allocate_board(board.nwords);
+  board.words = base + 1;
+  /* create the initial board */
+  initialize_board(&board);
+  if (q == 0)
+  {
+    output_init(&output, &board, format, every, gens);
+  }
+  start = now();
+  if (nthreads > 1 || depth > 1)
+  {
+    job.board = &board;
+    job.boards[0] = base;
+    job.boards[1] = next;
+    job.rule = &rule;
+    job.gens = gens;
+    job.depth = depth;
+    job.nthreads = nthreads;
+    job.one_word = one_word;
+    job.output = (q == 0) ? &output : NULL;
+    if (parallel_run(&job) == next)
+    {
+      next = base;
+      base = job.boards[1];
+      board.words = base + 1;
+    }
+  }
+  for (g = 0; nthreads == 1 && depth == 1 && g < gens; g++)
+  {
+    /* print the cells, then write the next generation into the spare board */
+    if (q == 0 && g % every == 0)
+    {
+      print_cells(&output, &board);
+    }
+    board_update(&board, next + 1, &rule, one_word);
+    swap = base;
+    base = next;
+    next = swap;
+    board.words = base + 1;
+  }
+  seconds = now() - start;
+  if (q == 0)
+  {
+    free(output.row);
+    if (fflush(stdout) != 0)
+    {
+      fprintf(stderr, "Error! Writing the output failed!\n");
+      exit(1);
+    }
+  }
+  else
+  {
+    fprintf(stderr, "%ld cells, %ld generations: %.6f s, %.4g cell updates/s"
+            "\n", board.len, gens, seconds,
+            (seconds > 0) ? (double)board.len * gens / seconds : 0.0);
+  }
+  free(base);
+  free(next);
+  if (rule.table != NULL)
+  {
+    free(rule.table);
+  }
+  print_memory_leaks();
+  return 0;
+}
+
+/*
+usage prints the command syntax and exits
+*/
+void usage(char *progname)
+{
+  fprintf(stderr, "usage: %s [-q] [-s seed] [-w] [-L] [-r rule | -t code "
+          "[-R radius]] [-j threads] [-k depth] [-e N] [-f text|pbm|raw] "
+          "population generations\n", progname);
+  exit(1);
+}
+
+/*
+allocate_board allocates a board of nwords words plus the zero word at each
+end, all of them empty
+*/
+uint64_t *allocate_board(long nwords)
+{
+  uint64_t *words = (uint64_t *) calloc(nwords + 2, sizeof(uint64_t));
+  /* Check that the calloc call succeeded. */
+  if (words == NULL)
+  {
+    fprintf(stderr, "Error! Memory allocation failed!\n");
+    exit(1);  /* abort the program */
+  }
+  return words;
+}
+
+/*
+initialize_board is a function that creates the first board. It uses a random
+variable to give each cell a 50% chance of being full or empty at the start,
+drawing them in the same order as 1dCA-Arrays.c, so the same seed gives the
+same board.
+*/
+void initialize_board(bit_board *board)
+{
+  long i;
+  for (i = 1; i < board->len - 1; i++)
+  {
+    if (rand() % 2)
+    {
+      board->words[i / WORD_BITS] |= (uint64_t)1 << (i % WORD_BITS);
+    }
+  }
+}
+
+/*
+elementary_rule sets up elementary rule number (or no rule if number is -1)
+by working out its algebraic normal form
+*/
+void elementary_rule(ca_rule *rule, int number)
+{
+  int set, p;
+  unsigned int term;
+  rule->number = number;
+  rule->radius = 1;
+  rule->table = NULL;
+  for (set = 0; set < 8; set++)
+  {
+    /*
+    the coefficient of a product of cells is the XOR of the rule's outputs
+    for every neighbourhood with no cells full outside it
+    */
+    term = 0;
+    for (p = 0; p < 8; p++)
+    {
+      if ((p & ~set) == 0 && number >= 0)
+      {
+        term ^= (number >> p) & 1;
+      }
+    }
+    rule->anf[set] = term ? ~(uint64_t)0 : 0;
+  }
+}
+
+/*
+make_table builds the rule's lookup table: for a totalistic rule with the
+given code and radius, or for its elementary rule if code is -1. Bit m of
+entry w is the next generation of the cell in the middle of bits m to
+m + 2 * radius of w.
+*/
+void make_table(ca_rule *rule, long code, int radius)
+{
+  long w, entries, outputs;
+  int m, j, index;
+  entries = 1L << (8 + 2 * radius);
+  /* bit k of outputs is the next generation of a cell with index k */
+  outputs = (code >= 0) ? code : rule->number;
+  rule->radius = radius;
+  rule->table = (unsigned char *) calloc(entries, 1);
+  /* Check that the calloc call succeeded. */
+  if (rule->table == NULL)
+  {
+    fprintf(stderr, "Error! Memory allocation failed!\n");
+    exit(1);  /* abort the program */
+  }
+  for (w = 0; w < entries; w++)
+  {
+    for (m = 0; m < 8; m++)
+    {
+      if (code >= 0)
+      {
+        /* a totalistic rule's index is the number of full cells */
+        index = 0;
+        for (j = 0; j <= 2 * radius; j++)
+        {
+          index += (w >> (m + j)) & 1;
+        }
+      }
+      else
+      {
+        /* left is the lowest bit of the window, but the highest of index */
+        index = (int)((((w >> m) & 1) << 2) | ((w >> m) & 2)
+                      | ((w >> (m + 2)) & 1));
+      }
+      if ((outputs >> index) & 1)
+      {
+        rule->table[w] |= 1 << m;
+      }
+    }
+  }
+}
+
+/*
+board_update_words computes words from..to-1 of the next generation under an
+elementary rule; the first and last cells are left for the caller to clear.
+*/
+void board_update_words(const uint64_t *words, uint64_t *next, long from,
+                        long to, const ca_rule *rule)
+{
+  long i;
+  uint64_t left, right, cells, a[8];
+  /* a local copy, which the compiler knows the stores to next can't change */
+  memcpy(a, rule->anf, sizeof(a));
+  if (rule->number == DEFAULT_RULE)
+  {
+    for (i = from; i < to; i++)
+    {
+      /* bit j of left is cell j - 1, and bit j of right is cell j + 1 */
+      left = (words[i] << 1) | (words[i - 1] >> (WORD_BITS - 1));
+      right = (words[i] >> 1) | (words[i + 1] << (WORD_BITS - 1));
+      next[i] = ~words[i] & (left ^ right);
+    }
+    return;
+  }
+  for (i = from; i < to; i++)
+  {
+    cells = words[i];
+    left = (cells << 1) | (words[i - 1] >> (WORD_BITS - 1));
+    right = (cells >> 1) | (words[i + 1] << (WORD_BITS - 1));
+    next[i] = a[0] ^ (a[1] & right) ^ (a[2] & cells) ^ (a[3] & cells & right)
+      ^ (a[4] & left) ^ (a[5] & left & right) ^ (a[6] & left & cells)
+      ^ (a[7] & left & cells & right);
+  }
+}
+
+/*
+table_update_words computes words from..to-1 of the next generation with the
+rule's lookup table, a byte (8 cells) at a time; the first and last cells are
+left for the caller to clear.
+*/
+void table_update_words(const uint64_t *words, uint64_t *next, long from,
+                        long to, const ca_rule *rule)
+{
+  long i;
+  int k, r = rule->radius;
+  uint64_t low, high, out;
+  uint64_t mask = ((uint64_t)1 << (8 + 2 * r)) - 1;
+  for (i = from; i < to; i++)
+  {
+    /*
+    low and high hold the 128 cells starting r cells before word i, so the
+    window for byte k of word i starts at bit 8k of them
+    */
+    low = (words[i] << r) | (words[i - 1] >> (WORD_BITS - r));
+    high = (words[i] >> (WORD_BITS - r)) | (words[i + 1] << r);
+    out = rule->table[low & mask];
+    for (k = 1; k < 8; k++)
+    {
+      out |= (uint64_t)rule->table[((low >> (8 * k))
+                                    | (high << (WORD_BITS - 8 * k))) & mask]
+        << (8 * k);
+    }
+    next[i] = out;
+  }
+}
+
+/*
+update_range computes words from..to-1 of the next generation based on the
+transition rule; in AVX2 builds, elementary rules go four words at a time
+unless one_word is set. The first and last cells are left for the caller to
+clear.
+*/
+void update_range(const uint64_t *words, uint64_t *next, long from, long to,
+                  const ca_rule *rule, int one_word)
+{
+  long i = from;
+#ifdef __AVX2__
+  __m256i cells, before, after, left, right, result, a[8];
+  uint64_t lanes[4];
+  int set;
+  for (set = 0; set < 8; set++)
+  {
+    lanes[0] = lanes[1] = lanes[2] = lanes[3] = rule->anf[set];
+    a[set] = _mm256_loadu_si256((const __m256i *)lanes);
+  }
+  /*
+  the words before and after each group of four are loaded from one word
+  further back and forward, so the shifted-in bits line up lane by lane
+  */
+  for (; !one_word && rule->table == NULL && i + 4 <= to; i += 4)
+  {
+    cells = _mm256_loadu_si256((const __m256i *)(words + i));
+    before = _mm256_loadu_si256((const __m256i *)(words + i - 1));
+    after = _mm256_loadu_si256((const __m256i *)(words + i + 1));
+    left = _mm256_or_si256(_mm256_slli_epi64(cells, 1),
+                           _mm256_srli_epi64(before, WORD_BITS - 1));
+    right = _mm256_or_si256(_mm256_srli_epi64(cells, 1),
+                            _mm256_slli_epi64(after, WORD_BITS - 1));
+    if (rule->number == DEFAULT_RULE)
+    {
+      result = _mm256_andnot_si256(cells, _mm256_xor_si256(left, right));
+    }
+    else
+    {
+      result = _mm256_xor_si256(
+        _mm256_xor_si256(
+          _mm256_xor_si256(a[0], _mm256_and_si256(a[1], right)),
+          _mm256_xor_si256(_mm256_and_si256(a[2], cells),
+                           _mm256_and_si256(a[3], _mm256_and_si256(cells,
+                                                                   right)))),
+        _mm256_xor_si256(
+          _mm256_xor_si256(_mm256_and_si256(a[4], left),
+                           _mm256_and_si256(a[5], _mm256_and_si256(left,
+                                                                   right))),
+          _mm256_xor_si256(
+            _mm256_and_si256(a[6], _mm256_and_si256(left, cells)),
+            _mm256_and_si256(a[7], _mm256_and_si256(
+                                     _mm256_and_si256(left, cells), right)))));
+    }
+    _mm256_storeu_si256((__m256i *)(next + i), result);
+  }
+#endif
+  if (rule->table != NULL)
+  {
+    table_update_words(words, next, i, to, rule);
+  }
+  else
+  {
+    board_update_words(words, next, i, to, rule);
+  }
+}
+
+/*
+board_update is a function that writes the next generation of the board into
+next based on the transition rule.
+*/
+void board_update(const bit_board *board, uint64_t *next,
+                  const ca_rule *rule, int one_word)
+{
+  update_range(board->words, next, 0, board->nwords, rule, one_word);
+  next[0] &= ~(uint64_t)1;
+  next[board->nwords - 1] &= board->last_mask;
+}
+
+/*
+run_chunk advances words lo..hi-1 of the board in cur by steps generations,
+writing them into spare. It copies the chunk, and steps words either side of
+it (the halo), into the worker's buffers and runs the generations there:
+each generation the words next to the ends of the copy go stale, since their
+neighbours weren't copied, so one word less on each side is computed, and
+after the last generation exactly the chunk is left.
+
+A cell depends only on cells at most MAX_RADIUS < 64 cells away, so one word
+of halo per generation is enough. Copies that reach the end of the board
+stop there, and its edges are handled as in board_update.
+*/
+void run_chunk(ca_worker *worker, const uint64_t *cur, uint64_t *spare,
+               long lo, long hi, int steps)
+{
+  const bit_board *board = worker->job->board;
+  uint64_t *a, *b, *swap;
+  long copy_lo, copy_hi, from, to;
+  int step;
+  copy_lo = (lo - steps > 0) ? lo - steps : 0;
+  copy_hi = (hi + steps < board->nwords) ? hi + steps : board->nwords;
+  /*
+  word j of the board is a[j - copy_lo]; the words either side of the copy
+  come along too, and are the zero guard words at the ends of the board
+  */
+  a = worker->buffers[0] + 1;
+  b = worker->buffers[1] + 1;
+  memcpy(a - 1, cur + copy_lo, (copy_hi - copy_lo + 2) * sizeof(uint64_t));
+  for (step = 1; step <= steps; step++)
+  {
+    from = (lo - steps + step > 0) ? lo - steps + step : 0;
+    to = (hi + steps - step < board->nwords) ? hi + steps - step
+      : board->nwords;
+    update_range(a, b, from - copy_lo, to - copy_lo, worker->job->rule,
+                 worker->job->one_word);
+    if (from == 0)
+    {
+      b[0] &= ~(uint64_t)1;
+    }
+    if (to == board->nwords)
+    {
+      b[to - 1 - copy_lo] &= board->last_mask;
+    }
+    /* keep the words either side, which may be guard words, for the next */
+    b[from - 1 - copy_lo] = a[from - 1 - copy_lo];
+    b[to - copy_lo] = a[to - copy_lo];
+    swap = a;
+    a = b;
+    b = swap;
+  }
+  memcpy(spare + 1 + lo, a + lo - copy_lo, (hi - lo) * sizeof(uint64_t));
+}
+
+/*
+tile_thread runs one thread of a tiled simulation. Each block of up to depth
+generations it advances its tile a chunk of CHUNK_WORDS words at a time with
+run_chunk, so the depth generations of a chunk run in cache and the board
+itself is only read and written once per block. A barrier, the only one in
+the block, makes sure every tile is written before the next block starts.
+*/
+void *tile_thread(void *arg)
+{
+  ca_worker *worker = (ca_worker *) arg;
+  ca_job *job = worker->job;
+  uint64_t *cur, *spare, *swap;
+  long lo, hi, chunk, g;
+  int steps;
+  bit_board view;
+  lo = job->board->nwords * worker->id / job->nthreads;
+  hi = job->board->nwords * (worker->id + 1) / job->nthreads;
+  cur = job->boards[0];
+  spare = job->boards[1];
+  view = *job->board;
+  for (g = 0; g < job->gens; g += steps)
+  {
+    steps = (job->gens - g < job->depth) ? (int)(job->gens - g) : job->depth;
+    if (job->output != NULL)
+    {
+      /* thread 0 prints; nobody writes this board until after the barrier */
+      if (worker->id == 0 && g % job->output->every == 0)
+      {
+        view.words = cur + 1;
+        print_cells(job->output, &view);
+      }
+      /* end the block at the next generation to be printed */
+      if (job->output->every - g % job->output->every < steps)
+      {
+        steps = (int)(job->output->every - g % job->output->every);
+      }
+    }
+    for (chunk = lo; chunk < hi; chunk += CHUNK_WORDS)
+    {
+      run_chunk(worker, cur, spare, chunk,
+                (hi - chunk < CHUNK_WORDS) ? hi : chunk + CHUNK_WORDS, steps);
+    }
+    pthread_barrier_wait(&job->barrier);
+    swap = cur;
+    cur = spare;
+    spare = swap;
+  }
+  if (worker->id == 0)
+  {
+    job->result = cur;
+  }
+  return NULL;
+}
+
+/*
+parallel_run runs the simulation on job->nthreads threads, the calling
+thread being one of them, and returns the base of the board holding the
+last generation
+*/
+uint64_t *parallel_run(ca_job *job)
+{
+  ca_worker *workers;
+  pthread_t *threads;
+  int i;
+  workers = (ca_worker *) malloc(job->nthreads * sizeof(ca_worker));
+  threads = (pthread_t *) malloc(job->nthreads * sizeof(pthread_t));
+  if (workers == NULL || threads == NULL)
+  {
+    fprintf(stderr, "Error! Memory allocation failed!\n");
+    exit(1);  /* abort the program */
+  }
+  if (pthread_barrier_init(&job->barrier, NULL, job->nthreads) != 0)
+  {
+    fprintf(stderr, "Error! Can't create a barrier!\n");
+    exit(1);
+  }
+  /* a worker's buffers hold a chunk, its halos and the guard words */
+  for (i = 0; i < job->nthreads; i++)
+  {
+    workers[i].job = job;
+    workers[i].id = i;
+    workers[i].buffers[0] = allocate_board(CHUNK_WORDS + 2 * job->depth);
+    workers[i].buffers[1] = allocate_board(CHUNK_WORDS + 2 * job->depth);
+  }
+  for (i = 1; i < job->nthreads; i++)
+  {
+    if (pthread_create(&threads[i], NULL, tile_thread, &workers[i]) != 0)
+    {
+      fprintf(stderr, "Error! Can't create a thread!\n");
+      exit(1);
+    }
+  }
+  tile_thread(&workers[0]);
+  for (i = 1; i < job->nthreads; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  pthread_barrier_destroy(&job->barrier);
+  for (i = 0; i < job->nthreads; i++)
+  {
+    free(workers[i].buffers[0]);
+    free(workers[i].buffers[1]);
+  }
+  free(workers);
+  free(threads);
+  return job->result;
+}
+
+/*
+output_init gets ready to write generations of the board in the given
+format, writing the PBM header, whose height is the number of generations
+that will be written
+*/
+void output_init(ca_output *out, const bit_board *board, int format,
+                 long every, long gens)
+{
+  int byte, bit;
+  out->format = format;
+  out->every = every;
+  /* a text row is written 8 cells at a time, so it may need up to 7 spare */
+  out->row_bytes = (board->len + 7) / 8;
+  out->row = (char *) malloc((format == FORMAT_TEXT) ? 8 * out->row_bytes + 1
+                             : out->row_bytes);
+  /* Check that the malloc call succeeded. */
+  if (out->row == NULL)
+  {
+    fprintf(stderr, "Error! Memory allocation failed!\n");
+    exit(1);  /* abort the program */
+  }
+  for (byte = 0; byte < 256; byte++)
+  {
+    out->reversed[byte] = 0;
+    for (bit = 0; bit < 8; bit++)
+    {
+      out->chars[byte][bit] = ((byte >> bit) & 1) ? '*' : '-';
+      out->reversed[byte] |= ((byte >> bit) & 1) << (7 - bit);
+    }
+  }
+  if (format == FORMAT_PBM)
+  {
+    printf("P4\n%ld %ld\n", board->len, (gens + every - 1) / every);
+  }
+}
+
+/*
+print_cells writes the board in the output's format: for text, a '-' for
+each empty cell and a '*' for each full one; for PBM, a bit per cell, the
+first cell in the most significant bit of the first byte
+*/
+void print_cells(ca_output *out, const bit_board *board)
+{
+  long j;
+  int byte;
+  if (out->format == FORMAT_RAW)
+  {
+    fwrite(board->words, sizeof(uint64_t), board->nwords, stdout);
+    return;
+  }
+  for (j = 0; j < out->row_bytes; j++)
+  {
+    /* byte j of the cells, whichever the machine's byte order */
+    byte = (int)((board->words[j / 8] >> (8 * (j % 8))) & 0xff);
+    if (out->format == FORMAT_TEXT)
+    {
+      memcpy(out->row + 8 * j, out->chars[byte], 8);
+    }
+    else
+    {
+      out->row[j] = (char)out->reversed[byte];
+    }
+  }
+  if (out->format == FORMAT_TEXT)
+  {
+    out->row[board->len] = '\n';
+    fwrite(out->row, 1, board->len + 1, stdout);
+  }
+  else
+  {
+    fwrite(out->row, 1, out->row_bytes, stdout);
+  }
+}
+
+/*
+now returns the current wall-clock time in seconds
+*/
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
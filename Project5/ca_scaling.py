@@ -0,0 +1,89 @@
+#! /usr/bin/env python3
+
+#
+# Strong-scaling benchmark for the bit-packed cellular automaton: runs the
+# same board for the same number of generations with 1, 2, 4, ... threads
+# (up to the number of processors, or --threads), at each temporal blocking
+# depth, and prints the cell updates per second with the speedup and
+# parallel efficiency relative to one thread at depth 1.
+#
+# usage: ca_scaling.py [--cells N] [--gens N] [--threads 1,2,4]
+#                      [--depths 1,4,16] [--rule ARGS] [--simd]
+#                      [--simdflags FLAGS] [--no-build]
+#
+
+import argparse, os, re, subprocess, sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def run(args, threads, depth):
+    '''Return the seconds taken by one run, or exit if it failed.'''
+    cmd = [os.path.join(HERE, 'bits'), '-q', '-s', '1', '-j', str(threads),
+           '-k', str(depth)] + args.rule.split() + [str(args.cells),
+                                                    str(args.gens)]
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    m = re.search(r': ([0-9.]+) s,', result.stderr)
+    if result.returncode != 0 or m is None:
+        sys.exit('{} failed:\n{}'.format(' '.join(cmd), result.stderr))
+    return float(m.group(1))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='CA strong scaling.')
+    parser.add_argument('--cells', type=int, default=10**9)
+    parser.add_argument('--gens', type=int, default=100)
+    parser.add_argument('--threads', default=None,
+                        help='comma-separated thread counts (default: '
+                        'powers of two up to the number of processors)')
+    parser.add_argument('--depths', default='1,4,16',
+                        help='comma-separated generations per barrier')
+    parser.add_argument('--rule', default='',
+                        help='rule options for bits, e.g. "-r 30"')
+    parser.add_argument('--repeat', type=int, default=1,
+                        help='runs per case; the best is kept')
+    parser.add_argument('--simd', action='store_true',
+                        help='build with SIMDFLAGS="-O2 -mavx2"')
+    parser.add_argument('--simdflags', default='',
+                        help='build with these SIMDFLAGS (the Makefile '
+                        'passes its own)')
+    parser.add_argument('--no-build', action='store_true')
+    args = parser.parse_args()
+
+    if not args.no_build:
+        cmd = ['make', '-B', 'bits']
+        if args.simdflags:
+            cmd.append('SIMDFLAGS=' + args.simdflags)
+        elif args.simd:
+            cmd.append('SIMDFLAGS=-O2 -mavx2')
+        result = subprocess.run(cmd, cwd=HERE, capture_output=True, text=True)
+        if result.returncode != 0:
+            sys.exit(result.stdout + result.stderr)
+
+    if args.threads:
+        threads = [int(t) for t in args.threads.split(',')]
+    else:
+        threads = [1]
+        while threads[-1] * 2 <= (os.cpu_count() or 1):
+            threads.append(threads[-1] * 2)
+    depths = [int(d) for d in args.depths.split(',')]
+
+    print('{} cells, {} generations, {} processors'.format(
+        args.cells, args.gens, os.cpu_count()))
+    print('{:>8} {:>6} {:>10} {:>14} {:>8} {:>10}'.format(
+        'threads', 'depth', 'seconds', 'updates/s', 'speedup', 'efficiency'))
+    base = None
+    for t in threads:
+        for d in depths:
+            seconds = min(run(args, t, d) for _ in range(args.repeat))
+            if base is None:
+                base = seconds
+            speedup = base / seconds if seconds > 0 else 0
+            print('{:>8} {:>6} {:>10.4f} {:>14.4g} {:>8.2f} {:>9.0f}%'.format(
+                t, d, seconds, args.cells * args.gens / seconds, speedup,
+                100 * speedup / t))
+            sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,114 @@
+/*
+ * FILE: bench_sort.c
+ *
+ *       Benchmark for the in-place list sorts in linked_list.h.
+ *
+ *       Each sort gets the same lists: uniformly random values, values
+ *       drawn from only 16 distinct numbers, and all-equal values.  The
+ *       nodes come from the node pool so memcheck only has to track the
+ *       slabs.  The copying make_quicksort lives in quicksorter.c and can
+ *       be timed on the same inputs with 'quicksorter -q -p -t -r N'.
+ *
+ *       usage: bench_sort [n]
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "linked_list.h"
+#include "node_pool.h"
+#include "memcheck.h"
+
+#define DEFAULT_N 10000000L
+
+unsigned int seed = 12345u;
+
+
+unsigned int next_random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+
+double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/* Make a list of 'n' values; 'distinct' == 0 means any value. */
+node *make_list(long n, unsigned int distinct)
+{
+    node *list = NULL;
+
+    seed = 12345u;
+    for (; n > 0; n--)
+    {
+        list = create_node(distinct == 0 ? (int)next_random()
+                           : (int)(next_random() % distinct), list);
+    }
+
+    return list;
+}
+
+
+void run(const char *input, unsigned int distinct, long n)
+{
+    node *list;
+    double start, quick, merge;
+
+    list = make_list(n, distinct);
+    start = now();
+    list = quicksort_list(list);
+    quick = now() - start;
+    if (!is_sorted(list))
+    {
+        fprintf(stderr, "quicksort_list failed on %s input\n", input);
+        exit(1);
+    }
+    free_list(list);
+
+    list = make_list(n, distinct);
+    start = now();
+    list = merge_sort_list(list);
+    merge = now() - start;
+    if (!is_sorted(list))
+    {
+        fprintf(stderr, "merge_sort_list failed on %s input\n", input);
+        exit(1);
+    }
+    free_list(list);
+
+    printf("%-12s %10.3f %10.3f\n", input, quick, merge);
+}
+
+
+int main(int argc, char *argv[])
+{
+    long n = DEFAULT_N;
+
+    if (argc > 2 || (argc == 2 && (n = atol(argv[1])) <= 0))
+    {
+        fprintf(stderr, "usage: %s [n]\n", argv[0]);
+        exit(1);
+    }
+
+    use_node_pool(1);
+
+    printf("sorting %ld values (seconds)\n", n);
+    printf("%-12s %10s %10s\n", "input", "quick", "merge");
+    run("random", 0, n);
+    run("16 distinct", 16, n);
+    run("all equal", 1, n);
+
+    node_pool_destroy();
+    print_memory_leaks();
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * FILE: bench_unrolled.c
+ *
+ *       Traversal and sort throughput of the unrolled list in
+ *       unrolled_list.h compared with the 'node' list in linked_list.h.
+ *
+ *       Both lists get the same random values.  The 'node' list is
+ *       allocated from the node pool (so neither list pays for memcheck
+ *       per value) and sorted with merge_sort_list, the stable sort that
+ *       ulist_sort corresponds to.
+ *
+ *       usage: bench_unrolled [n]
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "linked_list.h"
+#include "node_pool.h"
+#include "unrolled_list.h"
+#include "memcheck.h"
+
+#define DEFAULT_N 10000000L
+
+unsigned int seed = 12345u;
+
+
+unsigned int next_random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+
+double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/* Print one result line as millions of values per second. */
+void report(const char *what, long n, double node_time, double ulist_time)
+{
+    printf("%-10s %12.1f %12.1f\n", what,
+           n / node_time / 1e6, n / ulist_time / 1e6);
+}
+
+
+int main(int argc, char *argv[])
+{
+    long n = DEFAULT_N, i, node_sum = 0, ulist_sum = 0;
+    node *list, *other, *item;
+    ulist *ul, *uother;
+    ublock *block;
+    double start, node_time, ulist_time;
+    int j;
+
+    if (argc > 2 || (argc == 2 && (n = atol(argv[1])) <= 0))
+    {
+        fprintf(stderr, "usage: %s [n]\n", argv[0]);
+        exit(1);
+    }
+
+    use_node_pool(1);
+
+    printf("%ld values (millions of values per second)\n", n);
+    printf("%-10s %12s %12s\n", "operation", "node list", "unrolled");
+
+    /* Build: the node list is built backwards so both hold the same order. */
+    seed = 12345u;
+    start = now();
+    ul = ulist_create();
+    for (i = 0; i < n; i++)
+    {
+        ulist_push_back(ul, (int)next_random());
+    }
+    ulist_time = now() - start;
+
+    start = now();
+    list = NULL;
+    for (i = n - 1; i >= 0; i--)
+    {
+        list = create_node(0, list);
+    }
+    node_time = now() - start;
+    seed = 12345u;
+    for (item = list; item != NULL; item = item->next)
+    {
+        item->data = (int)next_random();
+    }
+    report("build", n, node_time, ulist_time);
+
+    start = now();
+    for (item = list; item != NULL; item = item->next)
+    {
+        node_sum += item->data;
+    }
+    node_time = now() - start;
+    start = now();
+    for (block = ul->head; block != NULL; block = block->next)
+    {
+        for (j = 0; j < block->count; j++)
+        {
+            ulist_sum += block->data[j];
+        }
+    }
+    ulist_time = now() - start;
+    if (node_sum != ulist_sum)
+    {
+        fprintf(stderr, "the lists hold different values\n");
+        exit(1);
+    }
+    report("traverse", n, node_time, ulist_time);
+
+    start = now();
+    other = copy_list(list);
+    node_time = now() - start;
+    start = now();
+    uother = ulist_copy(ul);
+    ulist_time = now() - start;
+    free_list(other);
+    ulist_free(uother);
+    report("copy", n, node_time, ulist_time);
+
+    start = now();
+    other = reverse_list(list);
+    node_time = now() - start;
+    start = now();
+    uother = ulist_reverse(ul);
+    ulist_time = now() - start;
+    free_list(other);
+    ulist_free(uother);
+    report("reverse", n, node_time, ulist_time);
+
+    start = now();
+    list = merge_sort_list(list);
+    node_time = now() - start;
+    start = now();
+    ulist_sort(ul);
+    ulist_time = now() - start;
+    if (!is_sorted(list) || !ulist_is_sorted(ul))
+    {
+        fprintf(stderr, "sort failed\n");
+        exit(1);
+    }
+    report("sort", n, node_time, ulist_time);
+
+    /* is_sorted has to walk the whole list only once it is sorted. */
+    start = now();
+    j = is_sorted(list);
+    node_time = now() - start;
+    start = now();
+    j += ulist_is_sorted(ul);
+    ulist_time = now() - start;
+    report("is_sorted", n, node_time, ulist_time);
+
+    free_list(list);
+    ulist_free(ul);
+    node_pool_destroy();
+    print_memory_leaks();
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * FILE: int_io.h
+ *
+ *       Buffered, streaming input and output of ints.
+ *
+ *       A reader pulls ints one at a time out of a FILE, either as text
+ *       (decimal numbers separated by whitespace, parsed by hand rather
+ *       than with scanf) or as binary int32 records in native byte order.
+ *       A writer formats ints as text, one per line, into a buffer that is
+ *       written out with fwrite.
+ *
+ *       Project3 and Project6 each build their own copy of int_io.c and
+ *       int_io.h.  The copies are kept identical, so change both.
+ *
+ */
+
+#ifndef INT_IO_H
+#define INT_IO_H
+
+#include <stdio.h>
+
+/* Size of the reader and writer buffers. */
+#define INT_IO_BUFFER 65536
+
+typedef struct
+{
+    FILE *fp;
+    int binary;    /* nonzero for int32 records, zero for text */
+    int eof;       /* nonzero once fread has hit the end of the file */
+    size_t pos;    /* next unread byte in 'buf' */
+    size_t len;    /* number of valid bytes in 'buf' */
+    char buf[INT_IO_BUFFER];
+} int_reader;
+
+typedef struct
+{
+    FILE *fp;
+    size_t used;   /* number of bytes waiting in 'buf' */
+    char buf[INT_IO_BUFFER];
+} int_writer;
+
+
+/* Start reading ints from 'fp', as binary records if 'binary' is nonzero. */
+void int_reader_init(int_reader *r, FILE *fp, int binary);
+
+/*
+ * Read the next int into '*value'.  Returns 1 if a value was read, 0 at
+ * the end of the input, or -1 (after printing a message to stderr) on a
+ * read error, a malformed or out-of-range number, or a truncated record.
+ */
+int int_reader_next(int_reader *r, int *value);
+
+/* Start writing ints to 'fp'. */
+void int_writer_init(int_writer *w, FILE *fp);
+
+/* Write one int followed by a newline.  Returns 0, or -1 on error. */
+int int_writer_put(int_writer *w, int value);
+
+/* Write out everything buffered so far.  Returns 0, or -1 on error. */
+int int_writer_flush(int_writer *w);
+
+#endif  /* INT_IO_H */
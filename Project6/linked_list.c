@@ -7,17 +7,50 @@
 #include <stdlib.h>
 #include "memcheck.h"
 #include "linked_list.h"
+#include "node_pool.h"
+#include "sort_counters.h"
+
+#ifdef SORT_COUNTERS
+unsigned long sort_comparisons = 0;
+unsigned long sort_moves = 0;
+#endif
+
+
+/* Nonzero if nodes come from the node pool instead of malloc. */
+static int pool_enabled = 0;
 
 
 /*
- * create_node:
- *     Create a single node and link it to the node called 'n'.
+ * use_node_pool:
+ *     Choose whether nodes are allocated from the node pool (nonzero)
+ *     or with malloc (zero).  Must be called before any node exists.
  */
 
-node *
-create_node(int data, node *n)
+void
+use_node_pool(int on)
+{
+    pool_enabled = on;
+}
+
+
+/*
+ * alloc_node:
+ *     Return an uninitialized node from the pool or from malloc.
+ */
+
+static node *
+alloc_node(void)
 {
-    node *result = (node *)malloc(sizeof(node));
+    node *result;
+
+    COUNT_MOVES(1);
+
+    if (pool_enabled)
+    {
+        return node_pool_alloc();
+    }
+
+    result = (node *)malloc(sizeof(node));
 
     if (result == NULL)
     {
@@ -26,6 +59,20 @@ create_node(int data, node *n)
         exit(1);
     }
 
+    return result;
+}
+
+
+/*
+ * create_node:
+ *     Create a single node and link it to the node called 'n'.
+ */
+
+node *
+create_node(int data, node *n)
+{
+    node *result = alloc_node();
+
     result->data = data;  /* Fill in the new node with the given value. */
     result->next = n;
 
@@ -54,7 +101,14 @@ free_list(node *list)
          * Since nothing points to 'n', it can be freed.
          */
 
-        free(n);
+        if (pool_enabled)
+        {
+            node_pool_free(n);
+        }
+        else
+        {
+            free(n);
+        }
     }
 }
 
@@ -67,29 +121,23 @@ free_list(node *list)
 node *
 copy_list(node *list)
 {
-    if (list == NULL)
-    {
-        return list;
-    }
-    else
-    {
-        node *new_list;
-
-        new_list = (node *)malloc(sizeof(node));
+    node *new_list = NULL;
+    node **tail = &new_list;  /* where the next copied node goes */
 
-        if (new_list == NULL)
-        {
-            fprintf(stderr, "Fatal error: out of memory. "
-                    "Terminating program.\n");
-            exit(1);
-        }
+    /*
+     * Copy iteratively so that long lists can't overflow the stack.
+     */
 
-        new_list->data = list->data;
-        new_list->next = copy_list(list->next);
-        return new_list;
+    for (; list != NULL; list = list->next)
+    {
+        *tail = alloc_node();
+        (*tail)->data = list->data;
+        tail = &(*tail)->next;
     }
-}
 
+    *tail = NULL;
+    return new_list;
+}
 
 
 /*
@@ -160,6 +208,375 @@ reverse_list(node *list)
 }
 
 
+/*
+ * quicksort_segment:
+ *     Sort a list in place and return its head, storing its last node
+ *     in '*last' (NULL for an empty list).  The list is split into the
+ *     nodes less than, equal to and greater than the first node's value,
+ *     keeping their original order within each part, and the less and
+ *     greater parts are sorted recursively.
+ */
+
+static node *
+quicksort_segment(node *list, node **last)
+{
+    node *less = NULL, *equal = NULL, *greater = NULL;
+    node **less_tail = &less, **equal_tail = &equal, **greater_tail = &greater;
+    node *less_last, *equal_last = NULL, *greater_last;
+    node *item;
+    int pivot;
+
+    if (list == NULL || list->next == NULL)
+    {
+        *last = list;
+        return list;
+    }
+
+    pivot = list->data;
+
+    for (item = list; item != NULL; item = item->next)
+    {
+        COUNT_MOVES(1);
+        if (LESS(item->data, pivot))
+        {
+            *less_tail = item;
+            less_tail = &item->next;
+        }
+        else if (LESS(pivot, item->data))
+        {
+            *greater_tail = item;
+            greater_tail = &item->next;
+        }
+        else
+        {
+            *equal_tail = item;
+            equal_tail = &item->next;
+            equal_last = item;
+        }
+    }
+
+    *less_tail = NULL;
+    *greater_tail = NULL;
+
+    /* The equal part is already sorted; splice the three parts together. */
+    less = quicksort_segment(less, &less_last);
+    greater = quicksort_segment(greater, &greater_last);
+
+    *equal_tail = greater;
+    *last = (greater != NULL) ? greater_last : equal_last;
+
+    if (less == NULL)
+    {
+        return equal;
+    }
+
+    less_last->next = equal;
+    return less;
+}
+
+
+/*
+ * quicksort_list:
+ *     Sort a list in place with a three-way partition quicksort.  The
+ *     recursion is as deep as the number of distinct values on sorted
+ *     input (see linked_list.h).
+ */
+
+node *
+quicksort_list(node *list)
+{
+    node *last;
+
+    return quicksort_segment(list, &last);
+}
+
+
+/*
+ * A list segment waiting to be sorted: the 'len' nodes starting at
+ * '*link'.  Keeping a pointer to the link that points at the first node
+ * lets the sorted segment be spliced back in place.
+ */
+
+typedef struct
+{
+    node **link;
+    long len;
+} segment;
+
+/*
+ * Every pushed segment is the larger side of a partition, and the next
+ * push comes from the smaller side, so at most log2(n) + 1 segments are
+ * ever waiting.
+ */
+#define SEGMENT_STACK 64
+
+static unsigned long pivot_seed = 12345UL;
+
+
+/*
+ * random_position:
+ *     Return a pseudo-random number in [0, n).
+ */
+
+static long
+random_position(long n)
+{
+    unsigned long r;
+
+    pivot_seed = (pivot_seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    r = pivot_seed >> 16;
+    pivot_seed = (pivot_seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    r = (r << 16) | (pivot_seed >> 16);
+
+    return (long)(r % (unsigned long)n);
+}
+
+
+/*
+ * median_of_three_pivot:
+ *     Return the median of the values at three random positions in the
+ *     'len' nodes starting at 'list'.  Only one walk down the segment is
+ *     needed, as far as the last of the three positions.
+ */
+
+static int
+median_of_three_pivot(node *list, long len)
+{
+    long pos[3], t, i;
+    int val[3], k, tmp;
+
+    for (k = 0; k < 3; k++)
+    {
+        pos[k] = random_position(len);
+    }
+
+    /* Sort the positions so that they can be visited in order. */
+    for (k = 1; k < 3; k++)
+    {
+        for (i = k; i > 0 && pos[i - 1] > pos[i]; i--)
+        {
+            t = pos[i];
+            pos[i] = pos[i - 1];
+            pos[i - 1] = t;
+        }
+    }
+
+    for (i = 0, k = 0; k < 3; list = list->next, i++)
+    {
+        while (k < 3 && pos[k] == i)
+        {
+            val[k++] = list->data;
+        }
+    }
+
+    /* Order the three values; the middle one is the median. */
+    COUNT_COMPARISONS(3);
+    if (val[0] > val[1])
+    {
+        tmp = val[0]; val[0] = val[1]; val[1] = tmp;
+    }
+    if (val[1] > val[2])
+    {
+        val[1] = val[2];
+    }
+    if (val[0] > val[1])
+    {
+        val[1] = val[0];
+    }
+
+    return val[1];
+}
+
+
+/*
+ * iterative_quicksort_list:
+ *     Sort a list in place with an iterative three-way quicksort.  Each
+ *     segment is partitioned into less/equal/greater sublists, which are
+ *     spliced back between the link before the segment and the node after
+ *     it.  The larger unsorted side is pushed and the loop carries on with
+ *     the smaller one.
+ */
+
+node *
+iterative_quicksort_list(node *list)
+{
+    segment stack[SEGMENT_STACK];
+    int top = 0;
+    segment seg, small, large;
+    node *less, *equal, *greater, *after, *item, *equal_last;
+    node **less_tail, **equal_tail, **greater_tail;
+    long i, nless, ngreater;
+    int pivot;
+
+    seg.link = &list;
+    for (seg.len = 0, item = list; item != NULL; item = item->next)
+    {
+        seg.len++;
+    }
+
+    for (;;)
+    {
+        if (seg.len < 2)
+        {
+            if (top == 0)
+            {
+                break;
+            }
+            seg = stack[--top];
+            continue;
+        }
+
+        pivot = median_of_three_pivot(*seg.link, seg.len);
+
+        less_tail = &less;
+        equal_tail = &equal;
+        greater_tail = &greater;
+        equal_last = NULL;
+        nless = ngreater = 0;
+
+        item = *seg.link;
+        for (i = 0; i < seg.len; i++)
+        {
+            COUNT_MOVES(1);
+            if (LESS(item->data, pivot))
+            {
+                *less_tail = item;
+                less_tail = &item->next;
+                nless++;
+            }
+            else if (LESS(pivot, item->data))
+            {
+                *greater_tail = item;
+                greater_tail = &item->next;
+                ngreater++;
+            }
+            else
+            {
+                *equal_tail = item;
+                equal_tail = &item->next;
+                equal_last = item;
+            }
+            item = item->next;
+        }
+        after = item;
+
+        /*
+         * The pivot is one of the segment's values, so 'equal' is never
+         * empty.  Splice less, equal and greater back into the list.
+         */
+
+        *greater_tail = after;
+        *equal_tail = greater;
+        *less_tail = equal;
+        *seg.link = less;
+
+        small.link = seg.link;
+        small.len = nless;
+        large.link = &equal_last->next;
+        large.len = ngreater;
+
+        if (small.len > large.len)
+        {
+            seg = small;
+            small = large;
+            large = seg;
+        }
+
+        if (large.len > 1)
+        {
+            stack[top++] = large;
+        }
+        seg = small;
+    }
+
+    return list;
+}
+
+
+/*
+ * merge:
+ *     Merge two sorted lists into one by relinking their nodes.  On equal
+ *     values nodes from 'a' come first, which keeps the sort stable.
+ */
+
+static node *
+merge(node *a, node *b)
+{
+    node *result = NULL;
+    node **tail = &result;
+
+    while (a != NULL && b != NULL)
+    {
+        COUNT_MOVES(1);
+        if (LESS(b->data, a->data))
+        {
+            *tail = b;
+            b = b->next;
+        }
+        else
+        {
+            *tail = a;
+            a = a->next;
+        }
+        tail = &(*tail)->next;
+    }
+
+    *tail = (a != NULL) ? a : b;
+    return result;
+}
+
+
+/*
+ * merge_sort_list:
+ *     Sort a list in place with a bottom-up merge sort.  Nodes are taken
+ *     off the front of the list one at a time; 'bins[i]' holds either
+ *     nothing or a sorted run of 2^i nodes, and adding a node carries
+ *     through the bins like incrementing a binary counter.  Runs in a
+ *     higher bin always came from earlier in the list, so merging them
+ *     as the first argument keeps the sort stable.
+ */
+
+#define MERGE_BINS 64
+
+node *
+merge_sort_list(node *list)
+{
+    node *bins[MERGE_BINS];
+    node *run;
+    int i, nbins = 0;
+
+    while (list != NULL)
+    {
+        run = list;
+        list = list->next;
+        run->next = NULL;
+
+        for (i = 0; i < nbins && bins[i] != NULL; i++)
+        {
+            run = merge(bins[i], run);
+            bins[i] = NULL;
+        }
+
+        if (i == nbins)
+        {
+            nbins++;
+        }
+        bins[i] = run;
+    }
+
+    run = NULL;
+    for (i = 0; i < nbins; i++)
+    {
+        if (bins[i] != NULL)
+        {
+            run = merge(bins[i], run);
+        }
+    }
+
+    return run;
+}
+
+
 /*
  * Print the elements of a list.
  */
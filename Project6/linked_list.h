@@ -20,6 +20,12 @@ typedef struct _node
 } node;
 
 
+/*
+ * Choose whether nodes are allocated from the node pool (nonzero) or
+ * with malloc (zero, the default).  Must be called before any node exists.
+ */
+void use_node_pool(int on);
+
 /* Create a single node and link it to the node called 'n'. */
 node *create_node(int data, node *n);
 
@@ -35,6 +41,33 @@ node *append_lists(node *list1, node *list2);
 /* Make a reversed copy of a list.  The input list is not altered. */
 node *reverse_list(node *list);
 
+/*
+ * Sort a list in place by relinking its nodes, using a quicksort with a
+ * three-way partition around the first element.  Stable; allocates
+ * nothing.  Returns the new head of the list.  Both sides of a partition
+ * are sorted recursively, so already sorted or reverse sorted input takes
+ * O(n^2) time and recurses O(n) deep; a sorted list of 100000 distinct
+ * values overflows a typical 8 MB stack.  Use iterative_quicksort_list
+ * or merge_sort_list when the input order is not known.
+ */
+node *quicksort_list(node *list);
+
+/*
+ * Sort a list in place by relinking its nodes, using a quicksort with a
+ * three-way partition around the median of three randomly chosen
+ * elements.  Segments are kept on an explicit stack and the smaller side
+ * is always sorted first, so the stack depth is O(log n) whatever the
+ * input, and the expected time is O(n log n).  Not stable; allocates
+ * nothing.  Returns the new head of the list.
+ */
+node *iterative_quicksort_list(node *list);
+
+/*
+ * Sort a list in place by relinking its nodes, using a bottom-up merge
+ * sort.  Stable; allocates nothing.  Returns the new head of the list.
+ */
+node *merge_sort_list(node *list);
+
 /* Print the elements of a list. */
 void print_list(node *list);
 
@@ -0,0 +1,127 @@
+/*
+ * FILE: node_pool.c
+ *
+ *       Implementation of the list node pool.
+ *
+ *       Slabs are kept in a linked list in the order they were allocated.
+ *       New nodes come from the free list if it isn't empty; otherwise they
+ *       are handed out in order from the current slab, moving on to the
+ *       next slab (or allocating a new one) when it's used up.  Resetting
+ *       the pool just empties the free list and rewinds to the first slab.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "memcheck.h"
+#include "node_pool.h"
+
+
+typedef struct _node_slab
+{
+    struct _node_slab *next;
+    node nodes[NODE_POOL_SLAB];
+} node_slab;
+
+
+static node_slab *first_slab = NULL;   /* all the slabs, oldest first       */
+static node_slab *current_slab = NULL; /* the slab new nodes are taken from */
+static int        current_used = 0;    /* nodes handed out from it so far   */
+static node      *free_nodes = NULL;   /* nodes returned by node_pool_free  */
+
+
+/*
+ * next_slab:
+ *     Move on to the slab after the current one, allocating it if this
+ *     is the last slab.
+ */
+
+static void
+next_slab(void)
+{
+    node_slab *slab;
+
+    if (current_slab != NULL && current_slab->next != NULL)
+    {
+        current_slab = current_slab->next;
+        current_used = 0;
+        return;
+    }
+
+    slab = (node_slab *)malloc(sizeof(node_slab));
+
+    if (slab == NULL)
+    {
+        fprintf(stderr, "Fatal error: out of memory. "
+                "Terminating program.\n");
+        exit(1);
+    }
+
+    slab->next = NULL;
+    if (current_slab == NULL)
+    {
+        first_slab = slab;
+    }
+    else
+    {
+        current_slab->next = slab;
+    }
+    current_slab = slab;
+    current_used = 0;
+}
+
+
+node *
+node_pool_alloc(void)
+{
+    node *n;
+
+    if (free_nodes != NULL)
+    {
+        n = free_nodes;
+        free_nodes = n->next;
+        return n;
+    }
+
+    if (current_slab == NULL || current_used == NODE_POOL_SLAB)
+    {
+        next_slab();
+    }
+
+    return &current_slab->nodes[current_used++];
+}
+
+
+void
+node_pool_free(node *n)
+{
+    n->next = free_nodes;
+    free_nodes = n;
+}
+
+
+void
+node_pool_reset(void)
+{
+    free_nodes = NULL;
+    current_slab = first_slab;
+    current_used = 0;
+}
+
+
+void
+node_pool_destroy(void)
+{
+    node_slab *slab;
+
+    while (first_slab != NULL)
+    {
+        slab = first_slab;
+        first_slab = slab->next;
+        free(slab);
+    }
+
+    current_slab = NULL;
+    current_used = 0;
+    free_nodes = NULL;
+}
@@ -0,0 +1,37 @@
+/*
+ * FILE: node_pool.h
+ *
+ *       A fixed-size pool allocator for list nodes.
+ *
+ *       Nodes are carved out of large slabs, and freed nodes go on a free
+ *       list, so allocating or freeing a node is O(1) and never calls
+ *       malloc except to add a slab.  The whole pool can also be reset at
+ *       once, which makes every node allocated from it free again without
+ *       visiting them.
+ *
+ */
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include "linked_list.h"
+
+/* Number of nodes in each slab. */
+#define NODE_POOL_SLAB 4096
+
+/* Return a node from the pool.  Its fields are not initialized. */
+node *node_pool_alloc(void);
+
+/* Return a node to the pool. */
+void node_pool_free(node *n);
+
+/*
+ * Make every node allocated from the pool free again.  The slabs are
+ * kept for reuse.  Any node still in use becomes invalid.
+ */
+void node_pool_reset(void);
+
+/* Free all the slabs.  Any node still in use becomes invalid. */
+void node_pool_destroy(void);
+
+#endif  /* NODE_POOL_H */
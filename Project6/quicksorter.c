@@ -1,30 +1,70 @@
 /*
-This file sorts any group of numbers presented as command arguments. It uses a
-quicksort. The only optional command argument is "-q", and this will suppress
-the printing of the sorted list.
+This file sorts any group of numbers presented as command arguments, or read
+from a file or stdin. It uses a quicksort. The optional command arguments are:
+  -q    suppress the printing of the sorted list
+  -p    allocate list nodes from the node pool instead of with malloc
+  -r N  sort N pseudo-random numbers (fixed seed) instead of the arguments
+  -d K  make the random numbers range over [0, K) instead of [0, RAND_MAX]
+  -a A  sort with algorithm A: "copy" (make_quicksort, the default), or the
+        in-place "quick" (quicksort_list), "iter" (iterative_quicksort_list,
+        safe on sorted and adversarial input) or "merge" (merge_sort_list)
+  -f F  also read numbers from file F ("-" for stdin): whitespace-separated
+        decimal text, or native int32 records with -b
+  -b    read -f input as binary int32 records
+  -t    print the time taken to read, sort and print to stderr, followed by
+        the number of comparisons and moves in builds with -DSORT_COUNTERS
 */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include "linked_list.h"
+#include "node_pool.h"
+#include "int_io.h"
+#include "sort_counters.h"
 #include "memcheck.h"
 
 node *make_quicksort(node *list);
+node *read_list(char *filename, int binary, node *list, long *count);
+double now(void);
+void usage(char *progname);
 
 int main(int argc, char *argv[])
 {
-  int quiet, i, count;
-  node *list, *sorted_list;
+  int quiet, pool, timed, binary, i;
+  long nrandom, distinct, count;
+  char *algorithm, *filename;
+  double start, read_time, sort_time;
+  int_writer *writer;
+  node *list, *sorted_list, *item;
   /* Checking to make sure a commandline argument was passed */
   if (argc == 1)
   {
-    fprintf(stderr, "usage: %s [-q] number1 [number2 ... ]\n", argv[0]);
-    exit(1);
+    usage(argv[0]);
   }
   quiet = 0;
+  pool = 0;
+  timed = 0;
+  binary = 0;
+  filename = NULL;
+  nrandom = -1;
+  distinct = 0;
+  algorithm = "copy";
   count = 0;
   list = NULL;
+  /* the pool has to be chosen before any node is created */
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-p") == 0)
+    {
+      pool = 1;
+    }
+  }
+  use_node_pool(pool);
+  start = now();
   /*
   Looping through each element and adding to linked list if int, or noting
   whether -q has been read using q variable
@@ -35,30 +75,225 @@ int main(int argc, char *argv[])
     {
       quiet = 1;
     }
+    else if (strcmp(argv[i], "-p") == 0)
+    {
+      /* already handled above */
+    }
+    else if (strcmp(argv[i], "-t") == 0)
+    {
+      timed = 1;
+    }
+    else if (strcmp(argv[i], "-b") == 0)
+    {
+      binary = 1;
+    }
+    else if (strcmp(argv[i], "-f") == 0)
+    {
+      if (i + 1 == argc)
+      {
+        usage(argv[0]);
+      }
+      filename = argv[++i];
+    }
+    else if (strcmp(argv[i], "-r") == 0)
+    {
+      if (i + 1 == argc || (nrandom = atol(argv[i + 1])) <= 0)
+      {
+        usage(argv[0]);
+      }
+      i++;
+    }
+    else if (strcmp(argv[i], "-d") == 0)
+    {
+      if (i + 1 == argc || (distinct = atol(argv[i + 1])) <= 0)
+      {
+        usage(argv[0]);
+      }
+      i++;
+    }
+    else if (strcmp(argv[i], "-a") == 0)
+    {
+      if (i + 1 == argc)
+      {
+        usage(argv[0]);
+      }
+      algorithm = argv[++i];
+      if (strcmp(algorithm, "copy") != 0 && strcmp(algorithm, "quick") != 0
+          && strcmp(algorithm, "iter") != 0
+          && strcmp(algorithm, "merge") != 0)
+      {
+        usage(argv[0]);
+      }
+    }
     else
     {
       list = create_node(atoi(argv[i]), list);
       count += 1;
     }
   }
-  /* return an error if no ints passed */
-  if (count == 0)
+  /* read the numbers from a file or stdin if asked to */
+  if (filename != NULL)
   {
-    fprintf(stderr, "usage: %s [-q] number1 [number2 ... ]\n", argv[0]);
-    exit(1);
+    list = read_list(filename, binary, list, &count);
+  }
+  /* generate the random numbers if asked to */
+  if (nrandom > 0)
+  {
+    srand(1);
+    for (; nrandom > 0; nrandom--)
+    {
+      list = create_node(distinct > 0 ? (int)(rand() % distinct) : rand(),
+                         list);
+      count += 1;
+    }
+  }
+  /* return an error if no ints passed (an empty file is fine) */
+  if (count == 0 && filename == NULL)
+  {
+    usage(argv[0]);
+  }
+  /*
+  the in-place sorts relink the input nodes, so the input list becomes the
+  sorted list and there is nothing separate to free
+  */
+  read_time = now() - start;
+#ifdef SORT_COUNTERS
+  /* don't count the nodes made while reading the input */
+  sort_comparisons = 0;
+  sort_moves = 0;
+#endif
+  start = now();
+  if (strcmp(algorithm, "quick") == 0)
+  {
+    sorted_list = quicksort_list(list);
+    list = NULL;
+  }
+  else if (strcmp(algorithm, "iter") == 0)
+  {
+    sorted_list = iterative_quicksort_list(list);
+    list = NULL;
+  }
+  else if (strcmp(algorithm, "merge") == 0)
+  {
+    sorted_list = merge_sort_list(list);
+    list = NULL;
+  }
+  else if (list != NULL)
+  {
+    sorted_list = make_quicksort(list);
+  }
+  else
+  {
+    sorted_list = NULL;
   }
-  sorted_list = make_quicksort(list);
+  sort_time = now() - start;
+  /* print through a buffered writer rather than one printf per number */
+  start = now();
   if (quiet == 0)
   {
-    print_list(sorted_list);
+    writer = (int_writer *)malloc(sizeof(int_writer));
+    if (writer == NULL)
+    {
+      fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+      exit(1);
+    }
+    int_writer_init(writer, stdout);
+    for (item = sorted_list; item != NULL; item = item->next)
+    {
+      if (int_writer_put(writer, item->data) == -1)
+      {
+        exit(1);
+      }
+    }
+    if (int_writer_flush(writer) == -1 || fflush(stdout) != 0)
+    {
+      exit(1);
+    }
+    free(writer);
+  }
+  if (timed)
+  {
+    fprintf(stderr, "%ld values: read %.6f s, sort %.6f s, print %.6f s\n",
+            count, read_time, sort_time, now() - start);
+#ifdef SORT_COUNTERS
+    fprintf(stderr, "%lu comparisons, %lu moves\n", sort_comparisons,
+            sort_moves);
+#endif
   }
   free_list(list);
   free_list(sorted_list);
+  if (pool)
+  {
+    node_pool_destroy();
+  }
   print_memory_leaks();
   return 0;
 }
 
 
+/*
+read_list reads numbers from the named file (or stdin for "-") onto the front
+of a list, adds how many it read to *count and returns the new list. It exits
+with an error message if the file can't be read or holds a bad number.
+*/
+node *read_list(char *filename, int binary, node *list, long *count)
+{
+  FILE *fp;
+  int_reader *reader;
+  int value, status;
+  if (strcmp(filename, "-") == 0)
+  {
+    fp = stdin;
+  }
+  else if ((fp = fopen(filename, binary ? "rb" : "r")) == NULL)
+  {
+    fprintf(stderr, "Error: can't open %s\n", filename);
+    exit(1);
+  }
+  /* the reader's buffer is too big to put on the stack */
+  reader = (int_reader *)malloc(sizeof(int_reader));
+  if (reader == NULL)
+  {
+    fprintf(stderr, "Fatal error: out of memory. Terminating program.\n");
+    exit(1);
+  }
+  int_reader_init(reader, fp, binary);
+  while ((status = int_reader_next(reader, &value)) == 1)
+  {
+    list = create_node(value, list);
+    *count += 1;
+  }
+  if (status == -1)
+  {
+    exit(1);
+  }
+  free(reader);
+  if (fp != stdin)
+  {
+    fclose(fp);
+  }
+  return list;
+}
+
+
+/* now returns the current wall-clock time in seconds */
+double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/* usage prints the command syntax and exits */
+void usage(char *progname)
+{
+  fprintf(stderr, "usage: %s [-q] [-p] [-t] [-a copy|quick|iter|merge] "
+          "[-f F [-b]] [-r N [-d K]] [number1 ... ]\n", progname);
+  exit(1);
+}
+
+
 /*
 make_quicksort is a function that accepts a linked list as an input and will
 return a linked list with quicksorted content of the input list via recursion
@@ -82,11 +317,11 @@ node *make_quicksort(node *list)
   list = list->next;
   for (item = list; item != NULL; item = item->next)
   {
-    if (item->data >= sorted_list->data)
+    if (!LESS(item->data, sorted_list->data))
     {
       greater_list = create_node(item->data, greater_list);
     }
-    if (item->data < sorted_list->data)
+    if (LESS(item->data, sorted_list->data))
     {
       lesser_list = create_node(item->data, lesser_list);
     }
@@ -0,0 +1,39 @@
+/*
+This file declares the comparison and move counters of the list sorts. They
+only exist in builds compiled with -DSORT_COUNTERS (see the *_counted targets
+in the Makefile); otherwise the counting macros compile to nothing, so the
+normal build is not slowed down.
+
+A comparison is one test of two values against each other. A move is one
+node relinked into a partition or merge, or one node allocated to hold a
+copied value.
+
+This file mirrors Project3/sort_counters.h for the array sorts. Only the
+meaning of a move differs between the two; keep the macros the same.
+*/
+
+#ifndef SORT_COUNTERS_H
+#define SORT_COUNTERS_H
+
+#ifdef SORT_COUNTERS
+
+extern unsigned long sort_comparisons;
+extern unsigned long sort_moves;
+
+/* atomic, since a sort may count from several threads at once */
+#define COUNT_COMPARISONS(n) \
+  ((void)__atomic_fetch_add(&sort_comparisons, (n), __ATOMIC_RELAXED))
+#define COUNT_MOVES(n) \
+  ((void)__atomic_fetch_add(&sort_moves, (n), __ATOMIC_RELAXED))
+
+#else
+
+#define COUNT_COMPARISONS(n) ((void)0)
+#define COUNT_MOVES(n)       ((void)0)
+
+#endif
+
+/* LESS compares two values, counting the comparison */
+#define LESS(a, b) (COUNT_COMPARISONS(1), (a) < (b))
+
+#endif
@@ -0,0 +1,421 @@
+/*
+ * FILE: unrolled_list.c
+ *
+ *       Implementation of the unrolled linked list.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memcheck.h"
+#include "unrolled_list.h"
+
+
+/*
+ * alloc_block:
+ *     Return an empty block, taking it from '*spare' if that isn't empty.
+ *     'spare' may be NULL.
+ */
+
+static ublock *
+alloc_block(ublock **spare)
+{
+    ublock *block;
+
+    if (spare != NULL && *spare != NULL)
+    {
+        block = *spare;
+        *spare = block->next;
+    }
+    else
+    {
+        block = (ublock *)malloc(sizeof(ublock));
+
+        if (block == NULL)
+        {
+            fprintf(stderr, "Fatal error: out of memory. "
+                    "Terminating program.\n");
+            exit(1);
+        }
+    }
+
+    block->count = 0;
+    block->next = NULL;
+    return block;
+}
+
+
+/*
+ * free_blocks:
+ *     Free a chain of blocks.
+ */
+
+static void
+free_blocks(ublock *block)
+{
+    ublock *next;
+
+    while (block != NULL)
+    {
+        next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+
+/*
+ * ulist_create:
+ *     Create an empty list.
+ */
+
+ulist *
+ulist_create(void)
+{
+    ulist *list = (ulist *)malloc(sizeof(ulist));
+
+    if (list == NULL)
+    {
+        fprintf(stderr, "Fatal error: out of memory. "
+                "Terminating program.\n");
+        exit(1);
+    }
+
+    list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    return list;
+}
+
+
+/*
+ * ulist_push_back:
+ *     Add a value to the end of a list, starting a new block if the last
+ *     one is full.
+ */
+
+void
+ulist_push_back(ulist *list, int data)
+{
+    if (list->tail == NULL)
+    {
+        list->head = list->tail = alloc_block(NULL);
+    }
+    else if (list->tail->count == UNROLLED_BLOCK)
+    {
+        list->tail->next = alloc_block(NULL);
+        list->tail = list->tail->next;
+    }
+
+    list->tail->data[list->tail->count++] = data;
+    list->length++;
+}
+
+
+/*
+ * ulist_free:
+ *     Free a list and all of its blocks.
+ */
+
+void
+ulist_free(ulist *list)
+{
+    free_blocks(list->head);
+    free(list);
+}
+
+
+/*
+ * copy_blocks:
+ *     Add a copy of every block of 'from' to the end of 'to', block for
+ *     block.
+ */
+
+static void
+copy_blocks(ulist *to, ulist *from)
+{
+    ublock *block, *copy;
+
+    for (block = from->head; block != NULL; block = block->next)
+    {
+        copy = alloc_block(NULL);
+        memcpy(copy->data, block->data, block->count * sizeof(int));
+        copy->count = block->count;
+
+        if (to->tail == NULL)
+        {
+            to->head = copy;
+        }
+        else
+        {
+            to->tail->next = copy;
+        }
+        to->tail = copy;
+    }
+
+    to->length += from->length;
+}
+
+
+/*
+ * ulist_copy:
+ *     Return a copy of a list.
+ */
+
+ulist *
+ulist_copy(ulist *list)
+{
+    ulist *result = ulist_create();
+
+    copy_blocks(result, list);
+    return result;
+}
+
+
+/*
+ * ulist_append:
+ *     Return a list which is a copy of the concatenation of the two
+ *     input lists.  The last block copied from 'list1' may be left
+ *     partly empty.
+ */
+
+ulist *
+ulist_append(ulist *list1, ulist *list2)
+{
+    ulist *result = ulist_create();
+
+    copy_blocks(result, list1);
+    copy_blocks(result, list2);
+    return result;
+}
+
+
+/*
+ * ulist_reverse:
+ *     Make a reversed copy of a list.  Each block is copied backwards
+ *     into a new block, which goes on the front of the result.
+ */
+
+ulist *
+ulist_reverse(ulist *list)
+{
+    ulist *result = ulist_create();
+    ublock *block, *copy;
+    int i;
+
+    for (block = list->head; block != NULL; block = block->next)
+    {
+        if (block->count == 0)
+        {
+            continue;
+        }
+
+        copy = alloc_block(NULL);
+        for (i = 0; i < block->count; i++)
+        {
+            copy->data[block->count - 1 - i] = block->data[i];
+        }
+        copy->count = block->count;
+
+        copy->next = result->head;
+        result->head = copy;
+        if (result->tail == NULL)
+        {
+            result->tail = copy;
+        }
+    }
+
+    result->length = list->length;
+    return result;
+}
+
+
+/*
+ * sort_block:
+ *     Sort the values of one block with an insertion sort.
+ */
+
+static void
+sort_block(ublock *block)
+{
+    int i, j, value;
+
+    for (i = 1; i < block->count; i++)
+    {
+        value = block->data[i];
+        for (j = i; j > 0 && block->data[j - 1] > value; j--)
+        {
+            block->data[j] = block->data[j - 1];
+        }
+        block->data[j] = value;
+    }
+}
+
+
+/*
+ * merge_runs:
+ *     Merge two sorted chains of blocks into a new chain.  Input blocks
+ *     go onto '*spare' as soon as they have been used up, and output
+ *     blocks are taken from there first.  On equal values 'a' comes
+ *     first.
+ */
+
+static ublock *
+merge_runs(ublock *a, ublock *b, ublock **spare)
+{
+    ublock *result, *out, *next;
+    int ia = 0, ib = 0;
+
+    result = out = alloc_block(spare);
+
+    while (a != NULL || b != NULL)
+    {
+        /* Retire used-up input blocks. */
+        if (a != NULL && ia == a->count)
+        {
+            next = a->next;
+            a->next = *spare;
+            *spare = a;
+            a = next;
+            ia = 0;
+            continue;
+        }
+        if (b != NULL && ib == b->count)
+        {
+            next = b->next;
+            b->next = *spare;
+            *spare = b;
+            b = next;
+            ib = 0;
+            continue;
+        }
+
+        if (out->count == UNROLLED_BLOCK)
+        {
+            out->next = alloc_block(spare);
+            out = out->next;
+        }
+
+        if (b == NULL || (a != NULL && a->data[ia] <= b->data[ib]))
+        {
+            out->data[out->count++] = a->data[ia++];
+        }
+        else
+        {
+            out->data[out->count++] = b->data[ib++];
+        }
+    }
+
+    return result;
+}
+
+
+/*
+ * ulist_sort:
+ *     Sort a list in place.  Blocks are sorted and taken off the front of
+ *     the list one at a time; as in merge_sort_list(), 'bins[i]' holds
+ *     either nothing or a sorted run made from 2^i blocks, and adding a
+ *     block carries through the bins like incrementing a binary counter.
+ */
+
+#define ULIST_BINS 64
+
+void
+ulist_sort(ulist *list)
+{
+    ublock *bins[ULIST_BINS];
+    ublock *spare = NULL;
+    ublock *run, *blocks = list->head;
+    int i, nbins = 0;
+
+    if (blocks == NULL)
+    {
+        return;
+    }
+
+    while (blocks != NULL)
+    {
+        run = blocks;
+        blocks = blocks->next;
+        run->next = NULL;
+        sort_block(run);
+
+        for (i = 0; i < nbins && bins[i] != NULL; i++)
+        {
+            run = merge_runs(bins[i], run, &spare);
+            bins[i] = NULL;
+        }
+
+        if (i == nbins)
+        {
+            nbins++;
+        }
+        bins[i] = run;
+    }
+
+    run = NULL;
+    for (i = 0; i < nbins; i++)
+    {
+        if (bins[i] != NULL)
+        {
+            run = (run == NULL) ? bins[i] : merge_runs(bins[i], run, &spare);
+        }
+    }
+
+    free_blocks(spare);
+
+    list->head = run;
+    for (list->tail = run; list->tail->next != NULL;
+         list->tail = list->tail->next)
+        ;
+}
+
+
+/*
+ * ulist_print:
+ *     Print the elements of a list.
+ */
+
+void
+ulist_print(ulist *list)
+{
+    ublock *block;
+    int i;
+
+    for (block = list->head; block != NULL; block = block->next)
+    {
+        for (i = 0; i < block->count; i++)
+        {
+            printf("%d\n", block->data[i]);
+        }
+    }
+}
+
+
+/*
+ * ulist_is_sorted:
+ *     Return 1 if a list is sorted, otherwise 0.
+ */
+
+int
+ulist_is_sorted(ulist *list)
+{
+    ublock *block;
+    int i, have_prev = 0, prev = 0;
+
+    for (block = list->head; block != NULL; block = block->next)
+    {
+        for (i = 0; i < block->count; i++)
+        {
+            if (have_prev && prev > block->data[i])
+            {
+                return 0;
+            }
+            prev = block->data[i];
+            have_prev = 1;
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,64 @@
+/*
+ * FILE: unrolled_list.h
+ *
+ *       An unrolled linked list of ints.  Instead of one number per node,
+ *       each block holds up to UNROLLED_BLOCK numbers in an array, so
+ *       walking the list touches far fewer pointers and cache lines than
+ *       a list of 'node's does.
+ *
+ */
+
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+/* Number of ints stored in each block. */
+#define UNROLLED_BLOCK 32
+
+typedef struct _ublock
+{
+    int count;                  /* number of values used in 'data' */
+    int data[UNROLLED_BLOCK];
+    struct _ublock *next;
+} ublock;
+
+typedef struct
+{
+    ublock *head;
+    ublock *tail;  /* last block, where ulist_push_back adds values */
+    long length;   /* total number of values in the list */
+} ulist;
+
+
+/* Create an empty list. */
+ulist *ulist_create(void);
+
+/* Add a value to the end of a list. */
+void ulist_push_back(ulist *list, int data);
+
+/* Free a list and all of its blocks. */
+void ulist_free(ulist *list);
+
+/* Return a copy of a list. */
+ulist *ulist_copy(ulist *list);
+
+/* Append two lists non-destructively.  The input lists are not altered. */
+ulist *ulist_append(ulist *list1, ulist *list2);
+
+/* Make a reversed copy of a list.  The input list is not altered. */
+ulist *ulist_reverse(ulist *list);
+
+/*
+ * Sort a list in place with a stable merge sort.  Each block is sorted
+ * first, then runs of blocks are merged bottom-up; blocks emptied by a
+ * merge are reused for its output, so only a few extra blocks are
+ * allocated.
+ */
+void ulist_sort(ulist *list);
+
+/* Print the elements of a list. */
+void ulist_print(ulist *list);
+
+/* Return 1 if a list is sorted, otherwise 0. */
+int ulist_is_sorted(ulist *list);
+
+#endif  /* UNROLLED_LIST_H */
@@ -0,0 +1,212 @@
+/*
+ * FILE: bench_concurrent.c
+ *
+ *       Read-throughput benchmark for the concurrent hash table.
+ *
+ *       The table is filled with NKEYS keys, then for each reader count
+ *       (1, 4 and the number of online cores) the readers look up random
+ *       keys for DURATION seconds while one writer thread keeps updating
+ *       existing keys and inserting new ones (which forces resizes).
+ *
+ *       usage: bench_concurrent [seconds]
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "concurrent_hash_table.h"
+#include "memcheck.h"
+
+#define NKEYS       100000
+#define DURATION    1.0
+#define KEY_LENGTH  16
+
+typedef struct
+{
+    chash_table *ht;
+    char **keys;
+    unsigned int seed;
+    long lookups;
+    long hits;
+} reader_args;
+
+chash_table *table;
+int stop;
+
+
+double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+char *make_key(long i)
+{
+    char *key = (char *)malloc(KEY_LENGTH);
+
+    if (key == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed!\n");
+        exit(1);
+    }
+    sprintf(key, "key%ld", i);
+    return key;
+}
+
+
+void *reader(void *arg)
+{
+    reader_args *r = (reader_args *)arg;
+    unsigned int x = r->seed;
+    long lookups = 0, hits = 0;
+
+    while (!__atomic_load_n(&stop, __ATOMIC_RELAXED))
+    {
+        int i;
+
+        /* Check the stop flag only every 256 lookups. */
+        for (i = 0; i < 256; i++)
+        {
+            x = x * 1103515245u + 12345u;
+            if (chash_get_value(r->ht, r->keys[(x >> 8) % NKEYS]) != 0)
+            {
+                hits++;
+            }
+        }
+        lookups += 256;
+    }
+
+    r->lookups = lookups;
+    r->hits = hits;
+    return NULL;
+}
+
+
+void *writer(void *arg)
+{
+    long next_key = *(long *)arg;
+    long i = 0;
+
+    while (!__atomic_load_n(&stop, __ATOMIC_RELAXED))
+    {
+        /* Alternate updates of existing keys with brand new keys. */
+        chash_set_value(table, make_key(i % NKEYS), (int)i + 1);
+        chash_set_value(table, make_key(next_key++), 1);
+        i++;
+    }
+
+    *(long *)arg = next_key;
+    return NULL;
+}
+
+
+void run(int nreaders, char **keys, double seconds, long *next_key)
+{
+    pthread_t *threads, writer_thread;
+    reader_args *args;
+    long total = 0;
+    double start, elapsed;
+    struct timespec tick;
+    int i;
+
+    threads = (pthread_t *)malloc(nreaders * sizeof(pthread_t));
+    args = (reader_args *)malloc(nreaders * sizeof(reader_args));
+
+    if (threads == NULL || args == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed!\n");
+        exit(1);
+    }
+
+    stop = 0;
+    start = now();
+    pthread_create(&writer_thread, NULL, writer, next_key);
+    for (i = 0; i < nreaders; i++)
+    {
+        args[i].ht = table;
+        args[i].keys = keys;
+        args[i].seed = 12345u + i;
+        pthread_create(&threads[i], NULL, reader, &args[i]);
+    }
+
+    tick.tv_sec = 0;
+    tick.tv_nsec = 10000000;
+    while (now() - start < seconds)
+    {
+        nanosleep(&tick, NULL);
+    }
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+    for (i = 0; i < nreaders; i++)
+    {
+        pthread_join(threads[i], NULL);
+        total += args[i].lookups;
+    }
+    pthread_join(writer_thread, NULL);
+    elapsed = now() - start;
+
+    /* No readers are running, so the retired arrays can be freed. */
+    chash_reclaim(table);
+
+    printf("%3d reader(s): %12.0f lookups/s  (%8.0f per reader)\n",
+           nreaders, total / elapsed, total / elapsed / nreaders);
+
+    free(threads);
+    free(args);
+}
+
+
+int main(int argc, char **argv)
+{
+    char **keys;
+    long i, next_key;
+    int ncores;
+    double seconds = DURATION;
+
+    if (argc > 1)
+    {
+        seconds = atof(argv[1]);
+    }
+
+    ncores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    table = create_chash_table();
+    keys = (char **)malloc(NKEYS * sizeof(char *));
+
+    if (keys == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed!\n");
+        exit(1);
+    }
+
+    for (i = 0; i < NKEYS; i++)
+    {
+        keys[i] = make_key(i);
+        chash_set_value(table, make_key(i), 1);
+    }
+    next_key = NKEYS;
+
+    run(1, keys, seconds, &next_key);
+    run(4, keys, seconds, &next_key);
+    if (ncores != 1 && ncores != 4)
+    {
+        run(ncores, keys, seconds, &next_key);
+    }
+
+    for (i = 0; i < NKEYS; i++)
+    {
+        free(keys[i]);
+    }
+    free(keys);
+    free_chash_table(table);
+    print_memory_leaks();
+    return 0;
+}
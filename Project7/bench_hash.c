@@ -0,0 +1,401 @@
+/*
+ * FILE: bench_hash.c
+ *
+ *       Lookup-latency benchmark comparing the chained hash table in
+ *       hash_table.h with the flat, inline-key table in flat_hash_table.h.
+ *
+ *       hash_table.h also differs from the flat table in its hash function
+ *       and its fixed NSLOTS slots, so a third table is measured as well:
+ *       a chained table with one malloc'ed node and key per entry, but the
+ *       flat table's FNV-1a hash, stored hash values and growth policy.
+ *       The "chained FNV" and "flat" rows then differ only in the layout
+ *       of the entries.
+ *
+ *       Both tables get the same random keys (4 to 30 characters, so some
+ *       of them are too long to be stored inline), then every key is
+ *       looked up ROUNDS times in a shuffled order, followed by the same
+ *       number of lookups of keys that are not present.
+ *
+ *       usage: bench_hash [nkeys [rounds]]
+ *
+ *       Cache behaviour can be compared with e.g.
+ *           perf stat -e cache-references,cache-misses ./bench_hash
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash_table.h"
+#include "flat_hash_table.h"
+#include "memcheck.h"
+
+#define DEFAULT_NKEYS  20000
+#define DEFAULT_ROUNDS 10
+#define MAX_KEY        30
+
+/* Same initial size and load limit as flat_hash_table.c. */
+#define FNV_INITIAL_SLOTS 128
+#define FNV_MAX_LOAD      2
+
+
+/* A chained table laid out like hash_table.h, hashed like the flat one. */
+typedef struct _fnv_node
+{
+    char *key;
+    unsigned int hashval;
+    int value;
+    struct _fnv_node *next;
+} fnv_node;
+
+typedef struct
+{
+    fnv_node **slot;
+    unsigned int nslots;   /* always a power of two */
+    int nentries;
+} fnv_table;
+
+unsigned int seed = 12345u;
+
+
+unsigned int next_random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+
+double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/* Make a random key; 'prefix' keeps hit and miss keys disjoint. */
+char *random_key(char prefix)
+{
+    int i, len = 4 + next_random() % (MAX_KEY - 3);
+    char *key = (char *)malloc(len + 1);
+
+    if (key == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed!\n");
+        exit(1);
+    }
+
+    key[0] = prefix;
+    for (i = 1; i < len; i++)
+    {
+        key[i] = 'a' + next_random() % 26;
+    }
+    key[len] = '\0';
+    return key;
+}
+
+
+char *copy_key(char *key)
+{
+    char *copy = (char *)malloc(strlen(key) + 1);
+
+    if (copy == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed!\n");
+        exit(1);
+    }
+    strcpy(copy, key);
+    return copy;
+}
+
+
+void *checked_malloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (p == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed!\n");
+        exit(1);
+    }
+    return p;
+}
+
+
+/* 32-bit FNV-1a, as in flat_hash_table.c. */
+unsigned int fnv_hash(char *s)
+{
+    unsigned int h = 2166136261u;
+
+    while (*s != '\0')
+    {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+fnv_node **create_fnv_slots(unsigned int nslots)
+{
+    fnv_node **slot = (fnv_node **)checked_malloc(nslots * sizeof(fnv_node *));
+    unsigned int i;
+
+    for (i = 0; i < nslots; i++)
+    {
+        slot[i] = NULL;
+    }
+    return slot;
+}
+
+
+fnv_table *create_fnv_table(void)
+{
+    fnv_table *ft = (fnv_table *)checked_malloc(sizeof(fnv_table));
+
+    ft->nslots = FNV_INITIAL_SLOTS;
+    ft->nentries = 0;
+    ft->slot = create_fnv_slots(ft->nslots);
+    return ft;
+}
+
+
+/* Double the number of slots, relinking the existing nodes. */
+void grow_fnv_table(fnv_table *ft)
+{
+    fnv_node **old = ft->slot;
+    unsigned int i, nold = ft->nslots;
+
+    ft->nslots *= 2;
+    ft->slot = create_fnv_slots(ft->nslots);
+
+    for (i = 0; i < nold; i++)
+    {
+        fnv_node *n = old[i];
+
+        while (n != NULL)
+        {
+            fnv_node *next = n->next;
+            fnv_node **head = &ft->slot[n->hashval & (ft->nslots - 1)];
+
+            n->next = *head;
+            *head = n;
+            n = next;
+        }
+    }
+    free(old);
+}
+
+
+int fnv_get_value(fnv_table *ft, char *key)
+{
+    unsigned int h = fnv_hash(key);
+    fnv_node *n = ft->slot[h & (ft->nslots - 1)];
+
+    for (; n != NULL; n = n->next)
+    {
+        if (n->hashval == h && strcmp(n->key, key) == 0)
+        {
+            return n->value;
+        }
+    }
+    return 0;
+}
+
+
+void fnv_set_value(fnv_table *ft, char *key, int value)
+{
+    unsigned int h = fnv_hash(key);
+    fnv_node *n, **head;
+
+    for (n = ft->slot[h & (ft->nslots - 1)]; n != NULL; n = n->next)
+    {
+        if (n->hashval == h && strcmp(n->key, key) == 0)
+        {
+            n->value = value;
+            return;
+        }
+    }
+
+    if ((unsigned int)ft->nentries >= FNV_MAX_LOAD * ft->nslots)
+    {
+        grow_fnv_table(ft);
+    }
+
+    n = (fnv_node *)checked_malloc(sizeof(fnv_node));
+    n->key = copy_key(key);
+    n->hashval = h;
+    n->value = value;
+    head = &ft->slot[h & (ft->nslots - 1)];
+    n->next = *head;
+    *head = n;
+    ft->nentries++;
+}
+
+
+void free_fnv_table(fnv_table *ft)
+{
+    unsigned int i;
+
+    for (i = 0; i < ft->nslots; i++)
+    {
+        fnv_node *n = ft->slot[i];
+
+        while (n != NULL)
+        {
+            fnv_node *next = n->next;
+
+            free(n->key);
+            free(n);
+            n = next;
+        }
+    }
+    free(ft->slot);
+    free(ft);
+}
+
+
+int main(int argc, char **argv)
+{
+    int nkeys = DEFAULT_NKEYS, rounds = DEFAULT_ROUNDS;
+    char **keys, **misses;
+    hash_table *ht;
+    fnv_table *vt;
+    flat_hash_table *ft;
+    double t, chained_hit, chained_miss, fnv_hit, fnv_miss, flat_hit,
+        flat_miss;
+    long sum = 0, nlookups;
+    int i, r;
+
+    if (argc > 1)
+    {
+        nkeys = atoi(argv[1]);
+    }
+    if (argc > 2)
+    {
+        rounds = atoi(argv[2]);
+    }
+
+    keys = (char **)malloc(nkeys * sizeof(char *));
+    misses = (char **)malloc(nkeys * sizeof(char *));
+    if (keys == NULL || misses == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed!\n");
+        exit(1);
+    }
+
+    ht = create_hash_table();
+    vt = create_fnv_table();
+    ft = create_flat_hash_table();
+
+    for (i = 0; i < nkeys; i++)
+    {
+        keys[i] = random_key('k');
+        misses[i] = random_key('m');
+        set_value(ht, copy_key(keys[i]), i + 1);
+        fnv_set_value(vt, keys[i], i + 1);
+        flat_set_value(ft, keys[i], i + 1);
+    }
+
+    /* Shuffle the lookup order so it doesn't follow insertion order. */
+    for (i = nkeys - 1; i > 0; i--)
+    {
+        int j = next_random() % (i + 1);
+        char *tmp = keys[i];
+
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+
+    nlookups = (long)nkeys * rounds;
+
+    t = now();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < nkeys; i++)
+        {
+            sum += get_value(ht, keys[i]);
+        }
+    }
+    chained_hit = (now() - t) / nlookups;
+
+    t = now();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < nkeys; i++)
+        {
+            sum += fnv_get_value(vt, keys[i]);
+        }
+    }
+    fnv_hit = (now() - t) / nlookups;
+
+    t = now();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < nkeys; i++)
+        {
+            sum -= 2 * flat_get_value(ft, keys[i]);
+        }
+    }
+    flat_hit = (now() - t) / nlookups;
+
+    t = now();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < nkeys; i++)
+        {
+            sum += get_value(ht, misses[i]);
+        }
+    }
+    chained_miss = (now() - t) / nlookups;
+
+    t = now();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < nkeys; i++)
+        {
+            sum += fnv_get_value(vt, misses[i]);
+        }
+    }
+    fnv_miss = (now() - t) / nlookups;
+
+    t = now();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < nkeys; i++)
+        {
+            sum += flat_get_value(ft, misses[i]);
+        }
+    }
+    flat_miss = (now() - t) / nlookups;
+
+    if (sum != 0)
+    {
+        fprintf(stderr, "Error: the tables disagree!\n");
+        return 1;
+    }
+
+    printf("%d keys, %d rounds\n", nkeys, rounds);
+    printf("                hit (ns)   miss (ns)\n");
+    printf("chained      %10.1f  %10.1f\n", chained_hit * 1e9,
+           chained_miss * 1e9);
+    printf("chained FNV  %10.1f  %10.1f\n", fnv_hit * 1e9, fnv_miss * 1e9);
+    printf("flat         %10.1f  %10.1f\n", flat_hit * 1e9, flat_miss * 1e9);
+
+    for (i = 0; i < nkeys; i++)
+    {
+        free(keys[i]);
+        free(misses[i]);
+    }
+    free(keys);
+    free(misses);
+    free_hash_table(ht);
+    free_fnv_table(vt);
+    free_flat_hash_table(ft);
+    print_memory_leaks();
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * FILE: bench_memcheck.c
+ *
+ *       Allocation throughput of the memory checker under threads.
+ *
+ *       Each thread repeatedly frees and reallocates blocks in a private
+ *       ring of WORKING_SET live blocks, all through the checked
+ *       malloc/free, for 1, 2, 4 and all-core thread counts.  A final run
+ *       hands every block to another thread to free, which exercises the
+ *       cross-thread path.
+ *
+ *       usage: bench_memcheck [operations per thread]
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "memcheck.h"
+
+#define DEFAULT_OPS  1000000
+#define WORKING_SET  256
+#define MAX_THREADS  256
+
+long ops_per_thread = DEFAULT_OPS;
+
+/* Blocks handed from the producer to the consumer in the last run. */
+void *handoff[WORKING_SET];
+long handoff_rounds;
+pthread_barrier_t handoff_barrier;
+
+
+double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+void *churn(void *arg)
+{
+    void *ring[WORKING_SET];
+    unsigned int x = (unsigned int)(size_t)arg;
+    long i;
+    int j;
+
+    for (j = 0; j < WORKING_SET; j++)
+    {
+        ring[j] = malloc(16);
+    }
+
+    for (i = 0; i < ops_per_thread; i++)
+    {
+        j = i % WORKING_SET;
+        x = x * 1103515245u + 12345u;
+        free(ring[j]);
+        ring[j] = malloc(8 + (x >> 24));
+    }
+
+    for (j = 0; j < WORKING_SET; j++)
+    {
+        free(ring[j]);
+    }
+    return NULL;
+}
+
+
+/*
+ * Consumer for the cross-thread run: wait for the producer to fill
+ * 'handoff', free every block, and let the producer refill it.
+ */
+void *free_handoff(void *arg)
+{
+    long r;
+    int j;
+
+    (void)arg;
+    for (r = 0; r < handoff_rounds; r++)
+    {
+        pthread_barrier_wait(&handoff_barrier);
+        for (j = 0; j < WORKING_SET; j++)
+        {
+            free(handoff[j]);
+        }
+        pthread_barrier_wait(&handoff_barrier);
+    }
+    return NULL;
+}
+
+
+void run(int nthreads)
+{
+    pthread_t threads[MAX_THREADS];
+    double t, elapsed;
+    int i;
+
+    t = now();
+    for (i = 0; i < nthreads; i++)
+    {
+        pthread_create(&threads[i], NULL, churn, (void *)(size_t)(i + 1));
+    }
+    for (i = 0; i < nthreads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    elapsed = now() - t;
+
+    printf("%3d thread(s): %12.0f malloc+free pairs/s  (%10.0f per thread)\n",
+           nthreads, nthreads * ops_per_thread / elapsed,
+           ops_per_thread / elapsed);
+}
+
+
+int main(int argc, char **argv)
+{
+    pthread_t consumer;
+    int ncores, j;
+    long r;
+    double t;
+
+    if (argc > 1)
+    {
+        ops_per_thread = atol(argv[1]);
+    }
+
+    ncores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncores > MAX_THREADS)
+    {
+        ncores = MAX_THREADS;
+    }
+
+    run(1);
+    run(2);
+    run(4);
+    if (ncores > 4)
+    {
+        run(ncores);
+    }
+
+    /* Cross-thread frees: allocate here, free in another thread. */
+    handoff_rounds = ops_per_thread / WORKING_SET;
+    pthread_barrier_init(&handoff_barrier, NULL, 2);
+    pthread_create(&consumer, NULL, free_handoff, NULL);
+
+    t = now();
+    for (r = 0; r < handoff_rounds; r++)
+    {
+        for (j = 0; j < WORKING_SET; j++)
+        {
+            handoff[j] = malloc(32);
+        }
+        pthread_barrier_wait(&handoff_barrier);
+        pthread_barrier_wait(&handoff_barrier);
+    }
+    printf("cross-thread:  %12.0f malloc+free pairs/s\n",
+           handoff_rounds * WORKING_SET / (now() - t));
+
+    pthread_join(consumer, NULL);
+    pthread_barrier_destroy(&handoff_barrier);
+
+    print_memory_leaks();
+    return 0;
+}
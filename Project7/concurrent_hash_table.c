@@ -0,0 +1,228 @@
+/*
+ * FILE: concurrent_hash_table.c
+ *
+ *       Implementation of the concurrent (lock-free reader) hash table.
+ *
+ *       Publication uses the GCC __atomic builtins: a writer fills in a
+ *       node or slot array completely and then makes it reachable with a
+ *       release store, and readers follow pointers with acquire loads, so
+ *       a reader that can see a node also sees its contents.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "concurrent_hash_table.h"
+#include "memcheck.h"
+
+
+/*
+ * Hash function (32-bit FNV-1a).  Unlike hash() in hash_table.c, this
+ * spreads keys over all the bits, so the table can be grown by doubling
+ * and indexed with a mask.
+ */
+static unsigned int chash(char *s)
+{
+    unsigned int h = 2166136261u;
+
+    while (*s != '\0')
+    {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+static void *chash_alloc(size_t size)
+{
+    void *mem = malloc(size);
+
+    if (mem == NULL)
+    {
+        fprintf(stderr, "Fatal error: out of memory. "
+                "Terminating program.\n");
+        exit(1);
+    }
+    return mem;
+}
+
+
+static chash_slots *create_slots(unsigned int nslots)
+{
+    chash_slots *t = (chash_slots *)chash_alloc(sizeof(chash_slots));
+
+    t->nslots = nslots;
+    t->slot = (chash_node **)calloc(nslots, sizeof(chash_node *));
+    t->next = NULL;
+
+    if (t->slot == NULL)
+    {
+        fprintf(stderr, "Fatal error: out of memory. "
+                "Terminating program.\n");
+        exit(1);
+    }
+    return t;
+}
+
+
+/* Free a slot array and its nodes.  Keys are freed only if 'free_keys'. */
+static void free_slots(chash_slots *t, int free_keys)
+{
+    chash_node *n, *next;
+    unsigned int i;
+
+    for (i = 0; i < t->nslots; i++)
+    {
+        for (n = t->slot[i]; n != NULL; n = next)
+        {
+            next = n->next;
+            if (free_keys)
+            {
+                free(n->key);
+            }
+            free(n);
+        }
+    }
+    free(t->slot);
+    free(t);
+}
+
+
+chash_table *create_chash_table(void)
+{
+    chash_table *ht = (chash_table *)chash_alloc(sizeof(chash_table));
+
+    ht->table = create_slots(CHASH_INITIAL_SLOTS);
+    ht->retired = NULL;
+    ht->nentries = 0;
+    pthread_mutex_init(&ht->write_lock, NULL);
+    return ht;
+}
+
+
+void free_chash_table(chash_table *ht)
+{
+    if (ht == NULL)
+    {
+        return;
+    }
+
+    chash_reclaim(ht);
+    free_slots(ht->table, 1);
+    pthread_mutex_destroy(&ht->write_lock);
+    free(ht);
+}
+
+
+int chash_get_value(chash_table *ht, char *key)
+{
+    chash_slots *t;
+    chash_node *n;
+    unsigned int h;
+
+    h = chash(key);
+    t = __atomic_load_n(&ht->table, __ATOMIC_ACQUIRE);
+    n = __atomic_load_n(&t->slot[h & (t->nslots - 1)], __ATOMIC_ACQUIRE);
+
+    while (n != NULL)
+    {
+        if (n->hashval == h && strcmp(n->key, key) == 0)
+        {
+            return __atomic_load_n(&n->value, __ATOMIC_RELAXED);
+        }
+        n = __atomic_load_n(&n->next, __ATOMIC_ACQUIRE);
+    }
+    return 0;
+}
+
+
+/*
+ * Double the size of the table.  The new array is built from copies of
+ * the current nodes (sharing their keys), so readers still walking the
+ * old array are unaffected.  Called with the write lock held.
+ */
+static void grow_table(chash_table *ht)
+{
+    chash_slots *old, *t;
+    chash_node *n, *copy;
+    unsigned int i, idx;
+
+    old = ht->table;
+    t = create_slots(old->nslots * 2);
+
+    for (i = 0; i < old->nslots; i++)
+    {
+        for (n = old->slot[i]; n != NULL; n = n->next)
+        {
+            copy = (chash_node *)chash_alloc(sizeof(chash_node));
+            copy->key = n->key;
+            copy->hashval = n->hashval;
+            copy->value = n->value;
+            idx = n->hashval & (t->nslots - 1);
+            copy->next = t->slot[idx];
+            t->slot[idx] = copy;
+        }
+    }
+
+    /* Publish the new array, then retire the old one. */
+    __atomic_store_n(&ht->table, t, __ATOMIC_RELEASE);
+    old->next = ht->retired;
+    ht->retired = old;
+}
+
+
+void chash_set_value(chash_table *ht, char *key, int value)
+{
+    chash_slots *t;
+    chash_node *n;
+    unsigned int h, idx;
+
+    h = chash(key);
+    pthread_mutex_lock(&ht->write_lock);
+
+    t = ht->table;
+    idx = h & (t->nslots - 1);
+
+    for (n = t->slot[idx]; n != NULL; n = n->next)
+    {
+        if (n->hashval == h && strcmp(n->key, key) == 0)
+        {
+            __atomic_store_n(&n->value, value, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&ht->write_lock);
+            free(key);
+            return;
+        }
+    }
+
+    n = (chash_node *)chash_alloc(sizeof(chash_node));
+    n->key = key;
+    n->hashval = h;
+    n->value = value;
+    n->next = t->slot[idx];
+    __atomic_store_n(&t->slot[idx], n, __ATOMIC_RELEASE);
+
+    ht->nentries++;
+    if ((unsigned int)ht->nentries > t->nslots)
+    {
+        grow_table(ht);
+    }
+
+    pthread_mutex_unlock(&ht->write_lock);
+}
+
+
+void chash_reclaim(chash_table *ht)
+{
+    chash_slots *t, *next;
+
+    pthread_mutex_lock(&ht->write_lock);
+    for (t = ht->retired; t != NULL; t = next)
+    {
+        next = t->next;
+        free_slots(t, 0);
+    }
+    ht->retired = NULL;
+    pthread_mutex_unlock(&ht->write_lock);
+}
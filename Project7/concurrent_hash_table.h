@@ -0,0 +1,84 @@
+/*
+ * FILE: concurrent_hash_table.h
+ *
+ *       A variant of the hash table in hash_table.h which can be read
+ *       from many threads at once while one thread at a time modifies it.
+ *
+ *       Readers never take a lock: chash_get_value() is wait-free.  Writers
+ *       serialize on a mutex.  When the table grows, the writer builds a new
+ *       slot array (with fresh copies of the nodes) and publishes it with a
+ *       single atomic pointer store, read-copy-update style.  Readers that
+ *       are still walking the old array see a consistent, if slightly stale,
+ *       snapshot.  The replaced arrays are kept on a "retired" list until
+ *       the program calls chash_reclaim() at a point where no reader can
+ *       still be inside chash_get_value() (a quiescent point), or until
+ *       the table is freed.
+ *
+ */
+
+#ifndef CONCURRENT_HASH_TABLE_H
+#define CONCURRENT_HASH_TABLE_H
+
+#include <pthread.h>
+
+/* Initial number of slots; always a power of two. */
+#define CHASH_INITIAL_SLOTS 128
+
+/*
+ * A node in one of the slot chains.  Once a node has been published its
+ * 'key', 'hashval' and 'next' fields never change; only 'value' does.
+ */
+
+typedef struct _chash_node
+{
+    char *key;
+    unsigned int hashval;        /* full hash of 'key', checked before strcmp */
+    int value;                   /* read and written atomically */
+    struct _chash_node *next;
+} chash_node;
+
+/* One generation of the slot array. */
+
+typedef struct _chash_slots
+{
+    unsigned int nslots;         /* a power of two */
+    chash_node **slot;
+    struct _chash_slots *next;   /* next array on the retired list */
+} chash_slots;
+
+typedef struct
+{
+    chash_slots *table;          /* current slot array, published atomically */
+    chash_slots *retired;        /* arrays replaced by resizing */
+    int nentries;                /* only touched with 'write_lock' held */
+    pthread_mutex_t write_lock;
+} chash_table;
+
+
+chash_table *create_chash_table(void);
+
+/* Free the table, including every retired slot array and all keys. */
+void free_chash_table(chash_table *ht);
+
+/*
+ * Look for a key in the table.  Return 0 if not found, otherwise the
+ * associated value.  Safe to call from any number of threads, concurrently
+ * with chash_set_value(), without blocking.
+ */
+int chash_get_value(chash_table *ht, char *key);
+
+/*
+ * Set the value stored at a key, adding the key if it is not present.
+ * As with set_value(), the table takes ownership of 'key' (which must
+ * have been allocated with malloc) and frees it if the key is already
+ * present.  Calls from different threads are serialized.
+ */
+void chash_set_value(chash_table *ht, char *key, int value);
+
+/*
+ * Free the slot arrays retired by earlier resizes.  The caller must
+ * guarantee that no thread is inside chash_get_value() on this table.
+ */
+void chash_reclaim(chash_table *ht);
+
+#endif  /* CONCURRENT_HASH_TABLE_H */
@@ -0,0 +1,259 @@
+/*
+ * FILE: flat_hash_table.c
+ *
+ *       Implementation of the cache-friendly hash table.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flat_hash_table.h"
+#include "memcheck.h"
+
+/* Grow the table when the average slot holds more than this many entries. */
+#define FLAT_MAX_LOAD 2
+
+
+/* Hash function (32-bit FNV-1a). */
+static unsigned int flat_hash(char *s)
+{
+    unsigned int h = 2166136261u;
+
+    while (*s != '\0')
+    {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+static void out_of_memory(void)
+{
+    fprintf(stderr, "Fatal error: out of memory. "
+            "Terminating program.\n");
+    exit(1);
+}
+
+
+/* Return the key stored in an entry, wherever it lives. */
+static char *entry_key(flat_entry *e)
+{
+    char *p;
+
+    if (e->key[FLAT_INLINE_KEY - 1] == FLAT_LONG_KEY)
+    {
+        memcpy(&p, e->key, sizeof(char *));
+        return p;
+    }
+    return e->key;
+}
+
+
+/* Store a copy of 'key' in an entry. */
+static void set_entry_key(flat_entry *e, char *key, size_t len)
+{
+    char *p;
+
+    memset(e->key, 0, FLAT_INLINE_KEY);
+
+    if (len < FLAT_INLINE_KEY)
+    {
+        memcpy(e->key, key, len);
+    }
+    else
+    {
+        p = (char *)malloc(len + 1);
+        if (p == NULL)
+        {
+            out_of_memory();
+        }
+        memcpy(p, key, len + 1);
+        memcpy(e->key, &p, sizeof(char *));
+        e->key[FLAT_INLINE_KEY - 1] = FLAT_LONG_KEY;
+    }
+}
+
+
+/* Append an entry to a slot, growing the slot's array if needed. */
+static flat_entry *slot_append(flat_slot *s)
+{
+    if (s->count == s->capacity)
+    {
+        int capacity = (s->capacity == 0) ? 2 : 2 * s->capacity;
+        flat_entry *entries;
+
+        entries = (flat_entry *)malloc(capacity * sizeof(flat_entry));
+        if (entries == NULL)
+        {
+            out_of_memory();
+        }
+        if (s->entries != NULL)
+        {
+            memcpy(entries, s->entries, s->count * sizeof(flat_entry));
+            free(s->entries);
+        }
+        s->entries = entries;
+        s->capacity = capacity;
+    }
+    return &s->entries[s->count++];
+}
+
+
+static flat_slot *create_slots(unsigned int nslots)
+{
+    flat_slot *slot = (flat_slot *)calloc(nslots, sizeof(flat_slot));
+
+    if (slot == NULL)
+    {
+        out_of_memory();
+    }
+    return slot;
+}
+
+
+/* Double the number of slots, moving every entry (keys included) as is. */
+static void grow_table(flat_hash_table *ht)
+{
+    flat_slot *old = ht->slot;
+    unsigned int i, nold = ht->nslots;
+    int j;
+
+    ht->nslots *= 2;
+    ht->slot = create_slots(ht->nslots);
+
+    for (i = 0; i < nold; i++)
+    {
+        for (j = 0; j < old[i].count; j++)
+        {
+            flat_entry *e = &old[i].entries[j];
+
+            *slot_append(&ht->slot[e->hashval & (ht->nslots - 1)]) = *e;
+        }
+        if (old[i].entries != NULL)
+        {
+            free(old[i].entries);
+        }
+    }
+    free(old);
+}
+
+
+flat_hash_table *create_flat_hash_table(void)
+{
+    flat_hash_table *ht = (flat_hash_table *)malloc(sizeof(flat_hash_table));
+
+    if (ht == NULL)
+    {
+        out_of_memory();
+    }
+
+    ht->nslots = FLAT_INITIAL_SLOTS;
+    ht->nentries = 0;
+    ht->slot = create_slots(ht->nslots);
+    return ht;
+}
+
+
+void free_flat_hash_table(flat_hash_table *ht)
+{
+    unsigned int i;
+    int j;
+
+    if (ht == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < ht->nslots; i++)
+    {
+        for (j = 0; j < ht->slot[i].count; j++)
+        {
+            flat_entry *e = &ht->slot[i].entries[j];
+
+            if (e->key[FLAT_INLINE_KEY - 1] == FLAT_LONG_KEY)
+            {
+                free(entry_key(e));
+            }
+        }
+        if (ht->slot[i].entries != NULL)
+        {
+            free(ht->slot[i].entries);
+        }
+    }
+    free(ht->slot);
+    free(ht);
+}
+
+
+/* Return the entry holding 'key', or NULL if there is none. */
+static flat_entry *find_entry(flat_hash_table *ht, char *key, unsigned int h)
+{
+    flat_slot *s = &ht->slot[h & (ht->nslots - 1)];
+    flat_entry *e = s->entries;
+    flat_entry *end = e + s->count;
+
+    for (; e < end; e++)
+    {
+        if (e->hashval == h && strcmp(entry_key(e), key) == 0)
+        {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+
+int flat_get_value(flat_hash_table *ht, char *key)
+{
+    flat_entry *e = find_entry(ht, key, flat_hash(key));
+
+    return (e == NULL) ? 0 : e->value;
+}
+
+
+void flat_set_value(flat_hash_table *ht, char *key, int value)
+{
+    unsigned int h = flat_hash(key);
+    flat_entry *e = find_entry(ht, key, h);
+
+    if (e != NULL)
+    {
+        e->value = value;
+        return;
+    }
+
+    if ((unsigned int)ht->nentries >= FLAT_MAX_LOAD * ht->nslots)
+    {
+        grow_table(ht);
+    }
+
+    e = slot_append(&ht->slot[h & (ht->nslots - 1)]);
+    e->hashval = h;
+    e->value = value;
+    set_entry_key(e, key, strlen(key));
+    ht->nentries++;
+}
+
+
+void print_flat_hash_table(flat_hash_table *ht)
+{
+    unsigned int i;
+    int j;
+
+    if (ht == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < ht->nslots; i++)
+    {
+        for (j = 0; j < ht->slot[i].count; j++)
+        {
+            flat_entry *e = &ht->slot[i].entries[j];
+
+            printf("%s %d\n", entry_key(e), e->value);
+        }
+    }
+}
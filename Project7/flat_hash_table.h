@@ -0,0 +1,78 @@
+/*
+ * FILE: flat_hash_table.h
+ *
+ *       A cache-friendly alternative to the hash table in hash_table.h.
+ *
+ *       Instead of a chain of separately allocated nodes, each slot holds
+ *       a small contiguous array of entries.  Each entry carries the full
+ *       hash of its key, so most non-matching entries are rejected without
+ *       touching the key, and keys of up to FLAT_INLINE_KEY - 1 characters
+ *       are stored inside the entry itself.  A lookup of a short key
+ *       therefore touches the slot array and one entry array, instead of
+ *       two allocations per chain step.
+ *
+ */
+
+#ifndef FLAT_HASH_TABLE_H
+#define FLAT_HASH_TABLE_H
+
+/* Bytes of key stored inline; longer keys are stored behind a pointer. */
+#define FLAT_INLINE_KEY 24
+
+/* Initial number of slots; always a power of two. */
+#define FLAT_INITIAL_SLOTS 128
+
+/*
+ * A single key/value pair; 32 bytes, so two share a cache line.  A short
+ * key is stored NUL-padded in 'key'.  A long key is stored as a pointer
+ * in the first bytes of 'key', with the last byte set to FLAT_LONG_KEY;
+ * the last byte of an inline key is always '\0'.
+ */
+
+#define FLAT_LONG_KEY 1
+
+typedef struct
+{
+    unsigned int hashval;
+    int value;
+    char key[FLAT_INLINE_KEY];
+} flat_entry;
+
+/* One slot: a growable array of entries. */
+
+typedef struct
+{
+    int count;
+    int capacity;
+    flat_entry *entries;
+} flat_slot;
+
+typedef struct
+{
+    unsigned int nslots;   /* a power of two */
+    int nentries;
+    flat_slot *slot;
+} flat_hash_table;
+
+
+flat_hash_table *create_flat_hash_table(void);
+
+void free_flat_hash_table(flat_hash_table *ht);
+
+/*
+ * Look for a key in the hash table.  Return 0 if not found.
+ * If it is found return the associated value.
+ */
+int flat_get_value(flat_hash_table *ht, char *key);
+
+/*
+ * Set the value stored at a key, adding the key if it is not in the
+ * table.  Unlike set_value(), the table keeps its own copy of the key;
+ * the caller still owns 'key'.
+ */
+void flat_set_value(flat_hash_table *ht, char *key, int value);
+
+/* Print out the contents of the hash table as key/value pairs. */
+void print_flat_hash_table(flat_hash_table *ht);
+
+#endif  /* FLAT_HASH_TABLE_H */
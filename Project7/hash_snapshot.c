@@ -0,0 +1,379 @@
+/*
+ * FILE: hash_snapshot.c
+ *
+ *       Writing, mapping and merging hash table snapshots.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hash_table.h"
+#include "hash_snapshot.h"
+#include "memcheck.h"
+
+
+/* A key/value pair waiting to be written to a snapshot. */
+
+typedef struct
+{
+    char *key;
+    unsigned int hashval;
+    int value;
+} snapshot_pair;
+
+
+/*
+ * Hash function (32-bit FNV-1a).  The snapshot has its own power-of-two
+ * slot count, so it needs a hash that uses all the bits.
+ */
+static unsigned int snapshot_hash(const char *s)
+{
+    unsigned int h = 2166136261u;
+
+    while (*s != '\0')
+    {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+static void *snapshot_alloc(size_t size)
+{
+    void *mem = malloc(size);
+
+    if (mem == NULL)
+    {
+        fprintf(stderr, "Fatal error: out of memory. "
+                "Terminating program.\n");
+        exit(1);
+    }
+    return mem;
+}
+
+
+/*
+ * Write 'n' pairs to a snapshot file.  The pairs are bucketed with a
+ * counting sort, so this is linear in the number of pairs.
+ */
+static int write_pairs(snapshot_pair *pairs, unsigned int n, char *filename)
+{
+    snapshot_header header;
+    snapshot_entry *entries;
+    unsigned int *slots, *fill, *order;
+    unsigned int i, j, s, nslots, keybytes;
+    FILE *fp;
+    int ok;
+
+    nslots = 1;
+    while (nslots < n)
+    {
+        nslots *= 2;
+    }
+
+    slots = (unsigned int *)calloc(nslots + 1, sizeof(unsigned int));
+    fill = (unsigned int *)calloc(nslots, sizeof(unsigned int));
+    order = (unsigned int *)snapshot_alloc((n + 1) * sizeof(unsigned int));
+    entries = (snapshot_entry *)snapshot_alloc(
+        (n + 1) * sizeof(snapshot_entry));
+
+    if (slots == NULL || fill == NULL)
+    {
+        fprintf(stderr, "Fatal error: out of memory. "
+                "Terminating program.\n");
+        exit(1);
+    }
+
+    /*
+     * Count the pairs in each slot and turn the counts into start
+     * offsets, then drop each pair into its slot.  'order[j]' is the
+     * pair that ends up in entry 'j'.
+     */
+    for (i = 0; i < n; i++)
+    {
+        slots[(pairs[i].hashval & (nslots - 1)) + 1]++;
+    }
+    for (s = 0; s < nslots; s++)
+    {
+        slots[s + 1] += slots[s];
+    }
+    for (i = 0; i < n; i++)
+    {
+        s = pairs[i].hashval & (nslots - 1);
+        order[slots[s] + fill[s]++] = i;
+    }
+
+    keybytes = 0;
+    for (j = 0; j < n; j++)
+    {
+        i = order[j];
+        entries[j].hashval = pairs[i].hashval;
+        entries[j].key = keybytes;
+        entries[j].value = pairs[i].value;
+        keybytes += strlen(pairs[i].key) + 1;
+    }
+
+    header.magic = SNAPSHOT_MAGIC;
+    header.nslots = nslots;
+    header.nentries = n;
+    header.keybytes = keybytes;
+
+    fp = fopen(filename, "wb");
+    ok = (fp != NULL);
+
+    if (ok)
+    {
+        ok = fwrite(&header, sizeof(header), 1, fp) == 1
+            && fwrite(slots, sizeof(unsigned int), nslots + 1, fp)
+               == nslots + 1
+            && fwrite(entries, sizeof(snapshot_entry), n, fp) == n;
+
+        /* The keys, in the same order as their offsets were assigned. */
+        for (j = 0; ok && j < n; j++)
+        {
+            char *key = pairs[order[j]].key;
+
+            ok = fwrite(key, 1, strlen(key) + 1, fp) == strlen(key) + 1;
+        }
+
+        if (fclose(fp) != 0)
+        {
+            ok = 0;
+        }
+    }
+
+    free(slots);
+    free(fill);
+    free(order);
+    free(entries);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Error writing snapshot file \"%s\".\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * Collect the pairs of a hash table, adding in the value each key has
+ * in 'snap' (if any).  Return the number of pairs stored in 'pairs',
+ * which must have room for every entry of the table.
+ */
+static unsigned int collect_table_pairs(hash_table *ht, hash_snapshot *snap,
+                                        snapshot_pair *pairs)
+{
+    node *list;
+    unsigned int n = 0;
+    int i;
+
+    for (i = 0; i < NSLOTS; i++)
+    {
+        for (list = ht->slot[i]; list != NULL; list = list->next)
+        {
+            pairs[n].key = list->key;
+            pairs[n].hashval = snapshot_hash(list->key);
+            pairs[n].value = list->value;
+            if (snap != NULL)
+            {
+                pairs[n].value += snapshot_get_value(snap, list->key);
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+
+static unsigned int count_table_entries(hash_table *ht)
+{
+    node *list;
+    unsigned int n = 0;
+    int i;
+
+    for (i = 0; i < NSLOTS; i++)
+    {
+        for (list = ht->slot[i]; list != NULL; list = list->next)
+        {
+            n++;
+        }
+    }
+    return n;
+}
+
+
+int write_hash_snapshot(hash_table *ht, char *filename)
+{
+    return merge_hash_snapshot(NULL, ht, filename);
+}
+
+
+int merge_hash_snapshot(hash_snapshot *snap, hash_table *ht, char *filename)
+{
+    snapshot_pair *pairs;
+    unsigned int n, j, total;
+    int result;
+
+    total = count_table_entries(ht);
+    if (snap != NULL)
+    {
+        total += snap->header->nentries;
+    }
+
+    pairs = (snapshot_pair *)snapshot_alloc(
+        (total + 1) * sizeof(snapshot_pair));
+    n = collect_table_pairs(ht, snap, pairs);
+
+    /*
+     * Keys that are only in the old snapshot are copied over as they
+     * are.  get_value() returns 0 for keys that aren't in the table.
+     */
+    if (snap != NULL)
+    {
+        for (j = 0; j < snap->header->nentries; j++)
+        {
+            char *key;
+
+            /* Entries whose key is outside the key area are dropped. */
+            if (snap->entries[j].key >= snap->header->keybytes)
+            {
+                continue;
+            }
+            key = (char *)snap->keys + snap->entries[j].key;
+            if (get_value(ht, key) == 0)
+            {
+                pairs[n].key = key;
+                pairs[n].hashval = snap->entries[j].hashval;
+                pairs[n].value = snap->entries[j].value;
+                n++;
+            }
+        }
+    }
+
+    result = write_pairs(pairs, n, filename);
+    free(pairs);
+    return result;
+}
+
+
+hash_snapshot *open_hash_snapshot(char *filename)
+{
+    hash_snapshot *snap;
+    const snapshot_header *h;
+    const unsigned int *slots;
+    const snapshot_entry *entries;
+    const char *keys;
+    struct stat st;
+    size_t expected;
+    void *base;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot open snapshot file \"%s\".\n", filename);
+        return NULL;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header))
+    {
+        fprintf(stderr, "\"%s\" is not a snapshot file.\n", filename);
+        close(fd);
+        return NULL;
+    }
+
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);   /* The mapping stays valid after the descriptor closes. */
+
+    if (base == MAP_FAILED)
+    {
+        fprintf(stderr, "Cannot map snapshot file \"%s\".\n", filename);
+        return NULL;
+    }
+
+    h = (const snapshot_header *)base;
+    expected = sizeof(snapshot_header)
+        + (h->nslots + (size_t)1) * sizeof(unsigned int)
+        + h->nentries * sizeof(snapshot_entry)
+        + h->keybytes;
+
+    if (h->magic != SNAPSHOT_MAGIC || h->nslots == 0
+        || (h->nslots & (h->nslots - 1)) != 0
+        || expected != (size_t)st.st_size)
+    {
+        fprintf(stderr, "\"%s\" is not a valid snapshot file.\n", filename);
+        munmap(base, st.st_size);
+        return NULL;
+    }
+
+    /*
+     * Only the header is checked here, so opening doesn't touch the rest
+     * of the mapping; the slot and key offsets are checked as they are
+     * used.  A terminated key area keeps strcmp() inside the mapping.
+     */
+    slots = (const unsigned int *)(h + 1);
+    entries = (const snapshot_entry *)(slots + h->nslots + 1);
+    keys = (const char *)(entries + h->nentries);
+    if (h->keybytes > 0 && keys[h->keybytes - 1] != '\0')
+    {
+        fprintf(stderr, "\"%s\" is not a valid snapshot file.\n", filename);
+        munmap(base, st.st_size);
+        return NULL;
+    }
+
+    snap = (hash_snapshot *)snapshot_alloc(sizeof(hash_snapshot));
+    snap->base = base;
+    snap->size = st.st_size;
+    snap->header = h;
+    snap->slots = slots;
+    snap->entries = entries;
+    snap->keys = keys;
+    return snap;
+}
+
+
+void close_hash_snapshot(hash_snapshot *snap)
+{
+    if (snap == NULL)
+    {
+        return;
+    }
+    munmap(snap->base, snap->size);
+    free(snap);
+}
+
+
+int snapshot_get_value(hash_snapshot *snap, char *key)
+{
+    unsigned int h, s, j, end;
+    const snapshot_entry *e;
+
+    h = snapshot_hash(key);
+    s = h & (snap->header->nslots - 1);
+
+    /* A slot or key offset outside the file's tables counts as no match. */
+    end = snap->slots[s + 1];
+    if (end > snap->header->nentries)
+    {
+        return 0;
+    }
+    for (j = snap->slots[s]; j < end; j++)
+    {
+        e = &snap->entries[j];
+        if (e->hashval == h && e->key < snap->header->keybytes
+            && strcmp(snap->keys + e->key, key) == 0)
+        {
+            return e->value;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * FILE: hash_snapshot.h
+ *
+ *       Read-only on-disk snapshots of a hash table.
+ *
+ *       A snapshot file is position independent: every reference inside
+ *       it is an offset, so it can be mapped into memory with mmap() and
+ *       searched in place, with no deserialization step.  Layout (all
+ *       integers are native-endian 32-bit unsigned):
+ *
+ *         header    magic, nslots, nentries, keybytes
+ *         slots     nslots + 1 entry indices; the entries of slot i are
+ *                   entries[slots[i]] .. entries[slots[i + 1] - 1]
+ *         entries   nentries records of (hash, key offset, value)
+ *         keys      keybytes bytes of NUL-terminated keys
+ *
+ */
+
+#ifndef HASH_SNAPSHOT_H
+#define HASH_SNAPSHOT_H
+
+#include <stddef.h>
+#include "hash_table.h"
+
+#define SNAPSHOT_MAGIC 0x50534854u   /* "THSP" */
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int nslots;      /* a power of two */
+    unsigned int nentries;
+    unsigned int keybytes;
+} snapshot_header;
+
+typedef struct
+{
+    unsigned int hashval;     /* full hash of the key, checked first */
+    unsigned int key;         /* offset of the key in the key area   */
+    int value;
+} snapshot_entry;
+
+/* An open (memory-mapped) snapshot. */
+
+typedef struct
+{
+    void *base;                       /* start of the mapping */
+    size_t size;                      /* length of the mapping */
+    const snapshot_header *header;
+    const unsigned int *slots;
+    const snapshot_entry *entries;
+    const char *keys;
+} hash_snapshot;
+
+
+/*
+ * Write the contents of a hash table to a snapshot file.
+ * Return 0 on success, -1 on failure (with a message on stderr).
+ */
+int write_hash_snapshot(hash_table *ht, char *filename);
+
+/*
+ * Map a snapshot file into memory.  Return NULL (with a message on
+ * stderr) if the file can't be opened or is not a valid snapshot.
+ */
+hash_snapshot *open_hash_snapshot(char *filename);
+
+/* Unmap a snapshot. */
+void close_hash_snapshot(hash_snapshot *snap);
+
+/*
+ * Look for a key in the snapshot.  Return 0 if not found.
+ * If it is found return the associated value.
+ */
+int snapshot_get_value(hash_snapshot *snap, char *key);
+
+/*
+ * Write a new snapshot to 'filename' holding every key of 'snap' and
+ * 'ht', with the values of keys present in both added together.  'snap'
+ * may be NULL, in which case this is the same as write_hash_snapshot().
+ * Return 0 on success, -1 on failure.
+ */
+int merge_hash_snapshot(hash_snapshot *snap, hash_table *ht,
+                        char *filename);
+
+#endif  /* HASH_SNAPSHOT_H */
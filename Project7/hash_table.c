@@ -208,3 +208,243 @@ void print_hash_table(hash_table *ht)
     }
   }
 }
+
+
+/*** Sorted output. ***/
+
+/*
+ * Compare two nodes by key.  Used with qsort() on an array of node
+ * pointers.
+ */
+static int compare_by_key(const void *a, const void *b)
+{
+  const node *na = *(const node * const *)a;
+  const node *nb = *(const node * const *)b;
+
+  return strcmp(na->key, nb->key);
+}
+
+
+/*
+ * Compare two nodes by value, breaking ties by key.  Used with qsort()
+ * on an array of node pointers.
+ */
+static int compare_by_count(const void *a, const void *b)
+{
+  const node *na = *(const node * const *)a;
+  const node *nb = *(const node * const *)b;
+
+  if (na->value != nb->value)
+  {
+    return (na->value < nb->value) ? -1 : 1;
+  }
+  return strcmp(na->key, nb->key);
+}
+
+
+/*
+ * Rank two nodes for the top-K report.  Return a positive number if 'a'
+ * ranks above 'b' (larger value, or equal value and smaller key), a
+ * negative number if it ranks below and 0 if they are the same node.
+ */
+static int rank_nodes(const node *a, const node *b)
+{
+  if (a->value != b->value)
+  {
+    return (a->value > b->value) ? 1 : -1;
+  }
+  return strcmp(b->key, a->key);
+}
+
+
+/* qsort() comparator putting the highest-ranked node first. */
+static int compare_by_rank(const void *a, const void *b)
+{
+  return rank_nodes(*(const node * const *)b, *(const node * const *)a);
+}
+
+
+/* Return the number of key/value pairs stored in the hash table. */
+static int count_entries(hash_table *ht)
+{
+  node *list;
+  int i, count;
+
+  count = 0;
+  for (i = 0; i < NSLOTS; i++)
+  {
+    for (list = ht->slot[i]; list != NULL; list = list->next)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+
+/*
+ * Restore the heap property of a min-heap of nodes (lowest rank at
+ * the root) by moving the node at position 'i' down.
+ */
+static void sift_down(node **heap, int size, int i)
+{
+  int child;
+  node *tmp;
+
+  while ((child = 2 * i + 1) < size)
+  {
+    if (child + 1 < size && rank_nodes(heap[child + 1], heap[child]) < 0)
+    {
+      child++;
+    }
+    if (rank_nodes(heap[child], heap[i]) >= 0)
+    {
+      break;
+    }
+    tmp = heap[i];
+    heap[i] = heap[child];
+    heap[child] = tmp;
+    i = child;
+  }
+}
+
+
+/* Restore the min-heap property by moving the node at 'i' up. */
+static void sift_up(node **heap, int i)
+{
+  int parent;
+  node *tmp;
+
+  while (i > 0)
+  {
+    parent = (i - 1) / 2;
+    if (rank_nodes(heap[i], heap[parent]) >= 0)
+    {
+      break;
+    }
+    tmp = heap[i];
+    heap[i] = heap[parent];
+    heap[parent] = tmp;
+    i = parent;
+  }
+}
+
+
+/*
+ * Print out the contents of the hash table as key/value pairs, sorted
+ * according to 'order'.  The nodes themselves are sorted through an
+ * array of pointers, so no keys are copied.
+ */
+void print_hash_table_sorted(hash_table *ht, int order)
+{
+  node **entries;
+  node *list;
+  int i, n, count;
+
+  if (ht == NULL)
+  {
+    return;
+  }
+
+  count = count_entries(ht);
+  if (count == 0)
+  {
+    return;
+  }
+
+  entries = (node **)malloc(count * sizeof(node *));
+
+  if (entries == NULL)
+  {
+    fprintf(stderr, "Fatal error: out of memory. "
+            "Terminating program.\n");
+    exit(1);
+  }
+
+  n = 0;
+  for (i = 0; i < NSLOTS; i++)
+  {
+    for (list = ht->slot[i]; list != NULL; list = list->next)
+    {
+      entries[n++] = list;
+    }
+  }
+
+  qsort(entries, count, sizeof(node *),
+        (order == ORDER_BY_COUNT) ? compare_by_count : compare_by_key);
+
+  for (i = 0; i < count; i++)
+  {
+    printf("%s %d\n", entries[i]->key, entries[i]->value);
+  }
+
+  free(entries);
+}
+
+
+/*
+ * Print out the 'k' key/value pairs with the largest values.  A min-heap
+ * of the best 'k' nodes seen so far is kept; its root is the weakest
+ * candidate, so each remaining node costs one comparison unless it
+ * displaces the root.  The heap never needs more room than the table
+ * has entries, however large 'k' is.
+ */
+void print_top_k(hash_table *ht, int k)
+{
+  node **heap;
+  node *list;
+  int i, size;
+
+  if (ht == NULL || k <= 0)
+  {
+    return;
+  }
+
+  size = count_entries(ht);
+  if (size == 0)
+  {
+    return;
+  }
+  if (k > size)
+  {
+    k = size;
+  }
+
+  heap = (node **)malloc(k * sizeof(node *));
+
+  if (heap == NULL)
+  {
+    fprintf(stderr, "Fatal error: out of memory. "
+            "Terminating program.\n");
+    exit(1);
+  }
+
+  size = 0;
+  for (i = 0; i < NSLOTS; i++)
+  {
+    for (list = ht->slot[i]; list != NULL; list = list->next)
+    {
+      if (size < k)
+      {
+        heap[size] = list;
+        sift_up(heap, size);
+        size++;
+      }
+      else if (rank_nodes(list, heap[0]) > 0)
+      {
+        heap[0] = list;
+        sift_down(heap, size, 0);
+      }
+    }
+  }
+
+  /* The heap holds the top 'k' nodes in heap order; sort them for output. */
+  qsort(heap, size, sizeof(node *), compare_by_rank);
+
+  for (i = 0; i < size; i++)
+  {
+    printf("%s %d\n", heap[i]->key, heap[i]->value);
+  }
+
+  free(heap);
+}
@@ -84,5 +84,22 @@ void set_value(hash_table *ht, char *key, int value);
 /* Print out the contents of the hash table as key/value pairs. */
 void print_hash_table(hash_table *ht);
 
+/* Orderings accepted by print_hash_table_sorted(). */
+#define ORDER_BY_KEY   0   /* ascending by key (strcmp order)        */
+#define ORDER_BY_COUNT 1   /* ascending by value, ties broken by key */
+
+/*
+ * Print out the contents of the hash table as key/value pairs, sorted
+ * according to 'order' (one of the ORDER_* constants above).
+ */
+void print_hash_table_sorted(hash_table *ht, int order);
+
+/*
+ * Print out the 'k' key/value pairs with the largest values, largest
+ * first.  Ties are broken by key.  Uses a bounded heap, so only O(k)
+ * extra memory is needed regardless of the size of the table.
+ */
+void print_top_k(hash_table *ht, int k);
+
 /* This line is part of the "include guard": */
 #endif  /* HASH_TABLE_H */
@@ -11,14 +11,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include "hash_table.h"
+#include "hash_snapshot.h"
 #include "memcheck.h"
 
 #define MAX_WORD_LENGTH 100
 
+/* Output modes selected on the command line. */
+#define OUTPUT_UNSORTED 0
+#define OUTPUT_BY_KEY   1
+#define OUTPUT_BY_COUNT 2
+#define OUTPUT_TOP_K    3
+
 
 void usage(char *progname)
 {
-    fprintf(stderr, "usage: %s filename\n", progname);
+    fprintf(stderr, "usage: %s [-k | -c | -t K] [-w snapshot | -m snapshot] "
+            "filename\n", progname);
+    fprintf(stderr, "  -k    print entries sorted by key\n");
+    fprintf(stderr, "  -c    print entries sorted by count\n");
+    fprintf(stderr, "  -t K  print only the K most frequent entries\n");
+    fprintf(stderr, "  -w S  write the counts to snapshot file S\n");
+    fprintf(stderr, "  -m S  merge the counts into snapshot file S\n");
 }
 
 void add_to_hash_table(hash_table *ht, char *key)
@@ -27,17 +40,115 @@ void add_to_hash_table(hash_table *ht, char *key)
     set_value(ht, key, v + 1);
 }
 
+/*
+ * Merge the counts in 'ht' into the snapshot file 'filename', creating
+ * it if it doesn't exist.  The merged snapshot is written next to the
+ * old one and renamed over it, so the old file stays intact (and can
+ * stay mapped) until the new one is complete.  Return 0 on success.
+ */
+int merge_into_snapshot(hash_table *ht, char *filename)
+{
+    hash_snapshot *snap = NULL;
+    FILE *existing;
+    char *tmpname;
+    int result;
+
+    existing = fopen(filename, "rb");
+    if (existing != NULL)
+    {
+        fclose(existing);
+        snap = open_hash_snapshot(filename);
+        if (snap == NULL)
+        {
+            return -1;
+        }
+    }
+
+    tmpname = (char *)malloc(strlen(filename) + 5);
+    if (tmpname == NULL)
+    {
+        fprintf(stderr, "Error: memory allocation failed! "
+                        "Terminating program.\n");
+        exit(1);
+    }
+    sprintf(tmpname, "%s.tmp", filename);
+
+    result = merge_hash_snapshot(snap, ht, tmpname);
+    close_hash_snapshot(snap);
+
+    if (result == 0 && rename(tmpname, filename) != 0)
+    {
+        fprintf(stderr, "Cannot rename \"%s\" to \"%s\".\n",
+                tmpname, filename);
+        remove(tmpname);
+        result = -1;
+    }
+
+    free(tmpname);
+    return result;
+}
+
 
 int main(int argc, char **argv)
 {
     int   nwords;
+    int   i, mode, top_k, status;
+    char *filename;
+    char *write_snapshot, *merge_snapshot;
     FILE *input_file;
     char  word[MAX_WORD_LENGTH];
     char  line[MAX_WORD_LENGTH];
     char *new_word;
     hash_table *ht;
 
-    if (argc != 2)
+    mode = OUTPUT_UNSORTED;
+    top_k = 0;
+    filename = NULL;
+    write_snapshot = NULL;
+    merge_snapshot = NULL;
+    status = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-k") == 0)
+        {
+            mode = OUTPUT_BY_KEY;
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            mode = OUTPUT_BY_COUNT;
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            mode = OUTPUT_TOP_K;
+            top_k = atoi(argv[++i]);
+            if (top_k <= 0)
+            {
+                usage(argv[0]);
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            write_snapshot = argv[++i];
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            merge_snapshot = argv[++i];
+        }
+        else if (filename == NULL && argv[i][0] != '-')
+        {
+            filename = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+
+    if (filename == NULL
+        || (write_snapshot != NULL && merge_snapshot != NULL))
     {
         usage(argv[0]);
         exit(1);
@@ -50,12 +161,12 @@ int main(int argc, char **argv)
      * Open the input file.  For simplicity, we specify that the
      * input file has to contain exactly one word per line.
      */
-    input_file = fopen(argv[1], "r");
+    input_file = fopen(filename, "r");
 
     if (input_file == NULL)  /* Open failed. */
     {
         fprintf(stderr, "Input file \"%s\" does not exist! "
-                        "Terminating program.\n", argv[1]);
+                        "Terminating program.\n", filename);
         return 1;
     }
 
@@ -92,7 +203,31 @@ int main(int argc, char **argv)
     }
 
     /* Print out the hash table key/value pairs. */
-    print_hash_table(ht);
+    switch (mode)
+    {
+    case OUTPUT_BY_KEY:
+        print_hash_table_sorted(ht, ORDER_BY_KEY);
+        break;
+    case OUTPUT_BY_COUNT:
+        print_hash_table_sorted(ht, ORDER_BY_COUNT);
+        break;
+    case OUTPUT_TOP_K:
+        print_top_k(ht, top_k);
+        break;
+    default:
+        print_hash_table(ht);
+        break;
+    }
+
+    /* Save the counts, if asked to. */
+    if (write_snapshot != NULL)
+    {
+        status = write_hash_snapshot(ht, write_snapshot);
+    }
+    else if (merge_snapshot != NULL)
+    {
+        status = merge_into_snapshot(ht, merge_snapshot);
+    }
 
     /* Clean up. */
     free_hash_table(ht);
@@ -101,5 +236,5 @@ int main(int argc, char **argv)
     /* Check for memory leaks. */
     print_memory_leaks();
 
-    return 0;
+    return (status == 0) ? 0 : 1;
 }
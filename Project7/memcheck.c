@@ -3,17 +3,108 @@
  *
  *       Simple-minded memory leak checker for C programs.
  *
+ *       Live allocations are tracked in a hash table keyed by address,
+ *       so recording a 'malloc' or looking up a 'free' takes constant
+ *       time no matter how many blocks are live.  The tracking records
+ *       themselves come from slabs and are recycled through a free list,
+ *       so tracking an allocation doesn't cost an extra 'malloc'.
+ *
+ *       Every allocation is also charged to its call site (file and line),
+ *       which gives an allocation profile: see print_allocation_profile().
+ *
+ *       The checker is thread-safe.  Each thread records its allocations
+ *       in its own tracker (pool, record slabs and call site table), guarded
+ *       by a per-tracker mutex that only that thread takes in the common
+ *       case, so threads don't contend on every malloc/free.  The trackers
+ *       are merged lazily: a free of a block allocated by another thread
+ *       searches the other trackers, and the leak and profile reports walk
+ *       all of them.  Trackers outlive their threads, so leaks by threads
+ *       that have already exited are still reported.  When a thread exits
+ *       its tracker is retired, and the next thread to start allocating
+ *       takes it over instead of registering a new one, so the registry
+ *       only grows to the largest number of threads allocating at once.
+ *
+ *       Finally, the checker keeps the current and peak number of live
+ *       bytes, and can sample the live byte count every Nth allocation
+ *       and/or every so many seconds into a ring buffer, giving a timeline
+ *       of heap usage: see memcheck_set_sampling().
+ *
+ *       Optionally, blocks can be guarded against overruns: see
+ *       memcheck_set_guard_mode().  In canary mode each block is padded
+ *       with a known byte pattern on both sides, which is checked when the
+ *       block is freed and by print_memory_leaks().  In guard page mode each
+ *       block gets its own mapping, placed so the block ends against an
+ *       inaccessible page, and overruns fault at the offending instruction.
+ *
  */
 
+#define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE         /* for MAP_ANONYMOUS */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
 
 #define MEMCHECK_C
 #include "memcheck.h"
 
 #define DEBUG 0
 
+/* Number of tracking records allocated at a time. */
+#define MEM_NODE_SLAB 1024
+
+/* Initial number of hash table buckets; always a power of two. */
+#define INITIAL_BUCKETS 1024
+
+/* Number of buckets in the call site table; a power of two. */
+#define SITE_BUCKETS 256
+
+/* Number of samples kept in the timeline ring buffer. */
+#define TIMELINE_SIZE 4096
+
+/* With time-based sampling, look at the clock every this many allocations. */
+#define CLOCK_CHECK_EVERY 64
+
+/*
+ * Size and fill byte of the canaries placed around guarded blocks.  The
+ * size keeps blocks 16-byte aligned.
+ */
+#define CANARY_SIZE 16
+#define CANARY_BYTE 0xAB
+
+/* Alignment of blocks placed against a guard page. */
+#define GUARD_ALIGN 16
+
+/* The largest size_t (SIZE_MAX is not in C89). */
+#define SIZE_LIMIT ((size_t)-1)
+
+/*
+ * Statistics for one call site.  Lifetimes are measured in allocations:
+ * a block's lifetime is the number of checked allocations recorded in
+ * the allocating thread's tracker (by that thread, or by a later thread
+ * that took the tracker over) between its allocation and its free.
+ * Allocations by other threads don't count.
+ */
+
+typedef
+struct _alloc_site
+{
+    char   *filename;
+    int     lineno;
+    unsigned long nallocs;      /* Number of allocations made here.     */
+    unsigned long nfrees;       /* Number of those that were freed.     */
+    double  nbytes;             /* Total bytes allocated here.          */
+    double  live_bytes;         /* Bytes allocated here and not freed.  */
+    double  peak_live_bytes;    /* Largest value of 'live_bytes'.       */
+    double  total_lifetime;     /* Sum of the lifetimes of freed blocks. */
+    struct _alloc_site *next;   /* Next site in the same bucket.        */
+}
+alloc_site;
+
 /*
  * Definition of data structure to keep memory allocation information.
  */
@@ -25,88 +116,396 @@ struct _mem_node
     size_t  nbytes;     /* Number of bytes allocated.                     */
     char   *filename;   /* Name of file where allocation occurred.        */
     int     lineno;     /* Line number of file where allocation occurred. */
-    struct _mem_node *next;     /* Next node in linked list. */
+    alloc_site *site;   /* Call site statistics for this allocation.      */
+    unsigned long birth;        /* Value of 'alloc_clock' when allocated. */
+    int     thread_num; /* Number of the thread that allocated it.        */
+    int     guard;      /* MEMCHECK_GUARD_* mode the block was made with. */
+    void   *base;       /* Start of the underlying allocation or mapping. */
+    size_t  span;       /* Length of the mapping (guard page mode only).  */
+    struct _mem_node *next;     /* Next node in the bucket (or free list). */
 }
 mem_node;
 
+/* A block of tracking records, linked so they can all be freed. */
+
+typedef
+struct _mem_slab
+{
+    struct _mem_slab *next;
+    mem_node nodes[MEM_NODE_SLAB];
+}
+mem_slab;
+
+/*
+ * The memory pool of one thread: a hash table of the live allocations
+ * made by the thread, the slabs and free list its tracking records come
+ * from, and its call site table.  Lifetimes are measured with the
+ * tracker's own allocation counter.  A tracker whose thread has exited
+ * is 'retired' but keeps its blocks and statistics until a new thread
+ * takes it over.  Each block records the number of the thread that
+ * allocated it, so reports name the real owner either way.
+ */
+
+typedef
+struct _mem_tracker
+{
+    pthread_mutex_t lock;
+    int         retired;        /* Thread exited; guarded by registry_lock. */
+    mem_node  **pool;
+    size_t      pool_buckets;
+    size_t      pool_count;     /* Written under 'lock', read atomically. */
+    mem_node   *free_nodes;
+    mem_slab   *slabs;
+    alloc_site *sites[SITE_BUCKETS];
+    size_t      nsites;
+    unsigned long alloc_clock;
+    struct _mem_tracker *next;  /* Next tracker in the registry. */
+}
+mem_tracker;
+
 
 /*
  * Function prototypes.
  */
 
+mem_tracker *get_tracker(void);
 void        allocate_mem_node(void *addr, size_t nbytes,
-                              char *filename, int lineno);
-void        free_mem_node(mem_node *n);
-void        free_mem_node_and_adjust_pool(mem_node *n);
+                              char *filename, int lineno,
+                              int guard, void *base, size_t span);
+void        free_mem_node(mem_tracker *t, mem_node *n);
+int         free_mem_node_and_adjust_pool(mem_tracker *t, void *addr,
+                                          char *filename, int lineno);
 void        free_all_mem_nodes(void);
-mem_node   *find_node(void *addr);
+mem_node   *find_node(mem_tracker *t, void *addr);
 void       *checked_malloc_fn(size_t size, char *filename, int lineno);
 void       *checked_calloc_fn(size_t nmemb, size_t size,
                               char *filename, int lineno);
 void        checked_free_fn(void *ptr, char *filename, int lineno);
 void        print_memory_leaks(void);
 void        dump_pool(void);
+alloc_site *find_site(mem_tracker *t, char *filename, int lineno);
+void        print_allocation_profile(FILE *fp);
+void        write_allocation_profile_csv(FILE *fp);
+void        note_allocation(size_t nbytes, unsigned long thread_clock);
+void        note_free(size_t nbytes);
+size_t      memcheck_live_bytes(void);
+size_t      memcheck_peak_bytes(void);
+void        memcheck_set_sampling(unsigned long every_n, double interval);
+int         memcheck_timeline(memcheck_sample *samples, int max);
+void        memcheck_dump_timeline(FILE *fp);
+void       *allocate_block(size_t size, int zero, int guard,
+                           void **base, size_t *span);
+void        release_block(mem_node *n);
+int         check_block(mem_node *n, char *filename, int lineno);
+void        memcheck_set_guard_mode(int mode);
+static void ensure_settings(void);
+
+
+/*
+ * The registry of all trackers, and the lock that guards it.  The
+ * registry lock is only taken when a thread makes its first allocation,
+ * when a block is freed by a thread other than the one that allocated
+ * it, and when reporting.
+ */
+
+mem_tracker    *trackers = NULL;
+int             ntrackers = 0;
+int             nthreads = 0;   /* Threads numbered so far (see below). */
+pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * The calling thread's tracker (NULL until its first allocation).  The
+ * same pointer is stored under 'tracker_key', whose destructor retires
+ * the tracker when the thread exits.
+ */
+
+static __thread mem_tracker *my_tracker = NULL;
+pthread_key_t   tracker_key;
+
+/*
+ * The calling thread's number: the order in which the threads made their
+ * first allocations.  A thread that takes over a retired tracker gets a
+ * new number, not the exited thread's.
+ */
 
+static __thread int my_thread_num = 0;
 
 /*
- * Initialize the memory pool linked list as a global variable.
+ * Heap usage over all threads.  These are updated with atomic operations
+ * rather than under a lock.
  */
 
-mem_node *pool = NULL;
+size_t          live_bytes = 0;
+size_t          peak_bytes = 0;
+unsigned long   total_allocs = 0;       /* Counted only while sampling. */
+
+/*
+ * The timeline: a ring buffer of samples, written only when a sample is
+ * due, under 'timeline_lock'.  'sample_every' and 'sample_interval' are
+ * read from the environment (see init_settings()) and can be changed
+ * with memcheck_set_sampling().
+ */
+
+memcheck_sample timeline[TIMELINE_SIZE];
+long            timeline_count = 0;     /* Samples taken, including lost. */
+unsigned long   sample_every = 0;
+double          sample_interval = 0.0;
+double          next_sample_time = 0.0;
+struct timespec start_time;
+pthread_mutex_t timeline_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Settings read from the environment once, before the first allocation
+ * (see init_settings()).
+ */
+
+pthread_once_t  settings_once = PTHREAD_ONCE_INIT;
+int             settings_ready = 0;
+int             guard_mode = MEMCHECK_GUARD_NONE;
+unsigned char   canary_pattern[CANARY_SIZE];    /* All CANARY_BYTE. */
 
 
 /**********************************************************************
  *
- * Low-level functions for managing the memory pool linked list.
+ * Low-level functions for managing the memory pools.
  *
  **********************************************************************/
 
+static void
+out_of_memory(void)
+{
+    fprintf(stderr, "ERROR: memory allocation failed!  Aborting...\n");
+    exit(1);
+}
+
+
 /*
- * Allocate a memory node, set its values and link it into the memory
- * pool linked list.
+ * Mark a tracker as retired when its thread exits (the destructor of
+ * 'tracker_key').  Its blocks stay in its pool, so they can still be
+ * freed by other threads and are still reported as leaks.
  */
 
-void
-allocate_mem_node(void *addr, size_t nbytes, char *filename, int lineno)
+static void
+retire_tracker(void *p)
 {
-    mem_node *n;
-    char *fn;
+    mem_tracker *t = (mem_tracker *)p;
+
+    pthread_mutex_lock(&registry_lock);
+    t->retired = 1;
+    pthread_mutex_unlock(&registry_lock);
+}
 
-    /* Create the node and set its fields. */
-    n = (mem_node *)malloc(sizeof(mem_node));
 
-    if (n == NULL)
+/*
+ * Return the calling thread's tracker.  On the thread's first allocation
+ * this takes over a retired tracker if there is one, and otherwise
+ * creates and registers a new one.  All access to a tracker's contents
+ * is under its lock, so a thread that is still exiting can safely share
+ * its tracker with the thread that took it over.
+ */
+
+mem_tracker *
+get_tracker(void)
+{
+    mem_tracker *t = my_tracker;
+
+    if (t == NULL)
     {
-        fprintf(stderr, "ERROR: memory allocation failed!  Aborting...\n");
-        exit(1);
+        ensure_settings();
+
+        pthread_mutex_lock(&registry_lock);
+        my_thread_num = nthreads++;
+        for (t = trackers; t != NULL && !t->retired; t = t->next)
+        {
+        }
+        if (t != NULL)
+        {
+            t->retired = 0;
+        }
+        pthread_mutex_unlock(&registry_lock);
+
+        if (t == NULL)
+        {
+            t = (mem_tracker *)calloc(1, sizeof(mem_tracker));
+
+            if (t == NULL)
+            {
+                out_of_memory();
+            }
+
+            pthread_mutex_init(&t->lock, NULL);
+
+            pthread_mutex_lock(&registry_lock);
+            ntrackers++;
+            t->next = trackers;
+            trackers = t;
+            pthread_mutex_unlock(&registry_lock);
+        }
+
+        my_tracker = t;
+        pthread_setspecific(tracker_key, t);
+    }
+
+    return t;
+}
+
+
+/*
+ * Hash an address.  The low bits of a heap address are mostly zero
+ * because of alignment, so multiply to mix the high bits down.
+ */
+
+static size_t
+hash_addr(mem_tracker *t, void *addr)
+{
+    unsigned long a = (unsigned long)addr;
+
+    a ^= a >> 4;
+    a *= 0x9E3779B1UL;
+    return (size_t)(a ^ (a >> 16)) & (t->pool_buckets - 1);
+}
+
+
+/*
+ * Double the number of buckets of a pool (or create the table, the
+ * first time) and rehash the live records into it.
+ */
+
+static void
+grow_pool(mem_tracker *t)
+{
+    mem_node **old = t->pool;
+    size_t i, nold = t->pool_buckets;
+    mem_node *n, *next;
+
+    t->pool_buckets = (nold == 0) ? INITIAL_BUCKETS : 2 * nold;
+    t->pool = (mem_node **)calloc(t->pool_buckets, sizeof(mem_node *));
+
+    if (t->pool == NULL)
+    {
+        out_of_memory();
+    }
+
+    for (i = 0; i < nold; i++)
+    {
+        for (n = old[i]; n != NULL; n = next)
+        {
+            size_t b = hash_addr(t, n->addr);
+
+            next = n->next;
+            n->next = t->pool[b];
+            t->pool[b] = n;
+        }
+    }
+
+    free(old);
+}
+
+
+/*
+ * Take a tracking record off a tracker's free list, allocating a new
+ * slab of them if the free list is empty.
+ */
+
+static mem_node *
+get_mem_node(mem_tracker *t)
+{
+    mem_node *n;
+
+    if (t->free_nodes == NULL)
+    {
+        mem_slab *slab = (mem_slab *)malloc(sizeof(mem_slab));
+        int i;
+
+        if (slab == NULL)
+        {
+            out_of_memory();
+        }
+
+        slab->next = t->slabs;
+        t->slabs = slab;
+
+        for (i = MEM_NODE_SLAB - 1; i >= 0; i--)
+        {
+            slab->nodes[i].next = t->free_nodes;
+            t->free_nodes = &slab->nodes[i];
+        }
     }
 
+    n = t->free_nodes;
+    t->free_nodes = n->next;
+    return n;
+}
+
+
+/*
+ * Allocate a memory node in the calling thread's pool and set its
+ * values.  'guard', 'base' and 'span' describe how the block was
+ * allocated (see allocate_block()).  The filename is not copied: it comes
+ * from __FILE__, which is a string literal and so lives for the whole
+ * program.
+ */
+
+void
+allocate_mem_node(void *addr, size_t nbytes, char *filename, int lineno,
+                  int guard, void *base, size_t span)
+{
+    mem_tracker *t = get_tracker();
+    mem_node *n;
+    unsigned long clock;
+    size_t b;
+
 #if DEBUG == 1
     fprintf(stderr, "Allocating %d bytes of memory at %p\n",
-            nbytes, addr);
+            (int)nbytes, addr);
 #endif
 
-    /* Copy the filename, which is statically allocated (I think). */
-    fn = (char *)malloc((strlen(filename) + 1) * sizeof(char));
-    strcpy(fn, filename);
+    pthread_mutex_lock(&t->lock);
+
+    if (t->pool_count >= t->pool_buckets)
+    {
+        grow_pool(t);
+    }
 
+    n = get_mem_node(t);
     n->addr     = addr;
     n->nbytes   = nbytes;
-    n->filename = fn;
+    n->filename = filename;
     n->lineno   = lineno;
+    n->site     = find_site(t, filename, lineno);
+    n->birth    = clock = t->alloc_clock++;
+    n->thread_num = my_thread_num;
+    n->guard    = guard;
+    n->base     = base;
+    n->span     = span;
+
+    n->site->nallocs++;
+    n->site->nbytes += nbytes;
+    n->site->live_bytes += nbytes;
+    if (n->site->live_bytes > n->site->peak_live_bytes)
+    {
+        n->site->peak_live_bytes = n->site->live_bytes;
+    }
+
+    b = hash_addr(t, addr);
+    n->next = t->pool[b];
+    t->pool[b] = n;
+    __atomic_store_n(&t->pool_count, t->pool_count + 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&t->lock);
 
-    /* Add it to the front of the memory pool. */
-    n->next = pool;
-    pool    = n;
+    note_allocation(nbytes, clock);
 }
 
 
 /*
- * Free a memory node from the pool.
+ * Free the memory tracked by a node and return the node to its
+ * tracker's free list.  The node must already have been unlinked from
+ * the pool, and the tracker must be locked.
  */
 
 void
-free_mem_node(mem_node *n)
+free_mem_node(mem_tracker *t, mem_node *n)
 {
     if (n != NULL)
     {
@@ -120,87 +519,141 @@ free_mem_node(mem_node *n)
         fprintf(stderr, "Freeing memory at %p\n", n->addr);
 #endif
 
-        free(n->addr);
-        free(n->filename);
-        free(n);
+        release_block(n);
+        n->addr = NULL;
+        n->next = t->free_nodes;
+        t->free_nodes = n;
     }
 }
 
 
 /*
- * Free a memory node from the pool.  Adjust the 'next' pointer of the
- * previous node (if any) to skip over this node.
+ * Find the node for 'addr' in a tracker's pool, unlink it and free it.
+ * Return 0 if the address was not found, 1 if it was, or 2 if it was but
+ * the block's canaries had been overwritten (which is reported, naming
+ * the 'filename' and 'lineno' of the free).  Takes the tracker's lock.
  */
 
-void
-free_mem_node_and_adjust_pool(mem_node *n)
+int
+free_mem_node_and_adjust_pool(mem_tracker *t, void *addr,
+                              char *filename, int lineno)
 {
-    mem_node *p, *prev;
+    mem_node **link, *n;
+    size_t nbytes = 0;
+    int found = 0;
 
-    prev = NULL;
+    pthread_mutex_lock(&t->lock);
 
-    for (p = pool; p != NULL; p = p->next)
+    if (t->pool_buckets > 0)
     {
-        if (p->addr == n->addr)
+        for (link = &t->pool[hash_addr(t, addr)]; *link != NULL;
+             link = &(*link)->next)
         {
-            if (prev == NULL)
-            {
-                /* The node to be removed is the first node. */
-                pool = p->next;
-                free_mem_node(p);
-                break;   /* Nothing left to do. */
-            }
-            else
+            n = *link;
+            if (n->addr == addr)
             {
-                /*
-                 * The node is in the interior of the memory pool
-                 * linked list.  Adjust the 'next' pointer of the
-                 * previous node and free the node.
-                 */
-                prev->next = p->next;
-                free_mem_node(p);
+                *link = n->next;
+                __atomic_store_n(&t->pool_count, t->pool_count - 1,
+                                 __ATOMIC_RELAXED);
+                n->site->nfrees++;
+                n->site->live_bytes -= n->nbytes;
+                n->site->total_lifetime += t->alloc_clock - n->birth;
+                nbytes = n->nbytes;
+                found = check_block(n, filename, lineno) ? 2 : 1;
+                free_mem_node(t, n);
                 break;   /* Nothing left to do. */
             }
         }
-        else
-        {
-            prev = p;
-        }
     }
+
+    pthread_mutex_unlock(&t->lock);
+
+    if (found)
+    {
+        note_free(nbytes);
+    }
+    return found;
 }
 
 
 /*
- * Free all the memory nodes from the pool.
+ * Free all the memory nodes from every pool, then the pools themselves.
+ * The trackers stay registered (threads may still hold them), but are
+ * left empty.
  */
 
 void
 free_all_mem_nodes(void)
 {
+    mem_tracker *t;
     mem_node *n, *next;
+    mem_slab *slab;
+    alloc_site *site, *next_site;
+    size_t i;
 
-    n = pool;
+    pthread_mutex_lock(&registry_lock);
 
-    while (n != NULL)
+    for (t = trackers; t != NULL; t = t->next)
     {
-        next = n->next;
-        free_mem_node(n);
-        n = next;
+        pthread_mutex_lock(&t->lock);
+
+        for (i = 0; i < t->pool_buckets; i++)
+        {
+            for (n = t->pool[i]; n != NULL; n = next)
+            {
+                next = n->next;
+                free_mem_node(t, n);
+            }
+        }
+
+        while (t->slabs != NULL)
+        {
+            slab = t->slabs;
+            t->slabs = slab->next;
+            free(slab);
+        }
+
+        free(t->pool);
+        t->pool = NULL;
+        t->pool_buckets = 0;
+        t->pool_count = 0;
+        t->free_nodes = NULL;
+
+        for (i = 0; i < SITE_BUCKETS; i++)
+        {
+            for (site = t->sites[i]; site != NULL; site = next_site)
+            {
+                next_site = site->next;
+                free(site);
+            }
+            t->sites[i] = NULL;
+        }
+        t->nsites = 0;
+
+        pthread_mutex_unlock(&t->lock);
     }
+
+    pthread_mutex_unlock(&registry_lock);
 }
 
 
 /*
- * Return the node that corresponds to the address 'addr', or NULL if
- * the address isn't found.
+ * Return the node in a tracker's pool that corresponds to the address
+ * 'addr', or NULL if the address isn't found.  The tracker must be
+ * locked.
  */
 
 mem_node *
-find_node(void *addr)
+find_node(mem_tracker *t, void *addr)
 {
     mem_node *n;
 
-    for (n = pool; n != NULL; n = n->next)
+    if (t->pool_buckets == 0)
+    {
+        return NULL;
+    }
+
+    for (n = t->pool[hash_addr(t, addr)]; n != NULL; n = n->next)
     {
         if (n->addr == addr)
         {
@@ -213,132 +666,946 @@ find_node(void *addr)
 
 
 /*
- * A debugging function to print the contents of the memory pool
- * linked list.
+ * Return a tracker's statistics record for a call site, creating it the
+ * first time the site is seen.  Sites are matched on the filename
+ * pointer: every allocation in a given source file passes the same
+ * __FILE__ literal.  The tracker must be locked.
+ */
+
+alloc_site *
+find_site(mem_tracker *t, char *filename, int lineno)
+{
+    alloc_site *site;
+    size_t b;
+
+    b = (((unsigned long)filename >> 3) * 31 + lineno) & (SITE_BUCKETS - 1);
+
+    for (site = t->sites[b]; site != NULL; site = site->next)
+    {
+        if (site->lineno == lineno && site->filename == filename)
+        {
+            return site;
+        }
+    }
+
+    site = (alloc_site *)calloc(1, sizeof(alloc_site));
+
+    if (site == NULL)
+    {
+        out_of_memory();
+    }
+
+    site->filename = filename;
+    site->lineno = lineno;
+    site->next = t->sites[b];
+    t->sites[b] = site;
+    t->nsites++;
+    return site;
+}
+
+
+/*
+ * A debugging function to print the contents of the memory pools.
+ * Other threads must not be allocating while this runs.
  */
 
 void
 dump_pool(void)
 {
+    mem_tracker *t;
     mem_node *n;
+    size_t i;
 
-    for (n = pool; n != NULL; n = n->next)
+    for (t = trackers; t != NULL; t = t->next)
     {
-        fprintf(stderr, "NODE --------\n");
-        fprintf(stderr, "location: %p\n", (void *)n);
-        fprintf(stderr, "addr: %p\n", n->addr);
-        fprintf(stderr, "nbytes: %d\n", (int)n->nbytes);
-        fprintf(stderr, "filename: %s\n", n->filename);
-        fprintf(stderr, "line number: %d\n", n->lineno);
-        fprintf(stderr, "next: %p\n", (void *)n->next);
-        fprintf(stderr, "\n");
+        for (i = 0; i < t->pool_buckets; i++)
+        {
+            for (n = t->pool[i]; n != NULL; n = n->next)
+            {
+                fprintf(stderr, "NODE --------\n");
+                fprintf(stderr, "location: %p\n", (void *)n);
+                fprintf(stderr, "thread: %d\n", n->thread_num);
+                fprintf(stderr, "bucket: %d\n", (int)i);
+                fprintf(stderr, "addr: %p\n", n->addr);
+                fprintf(stderr, "nbytes: %d\n", (int)n->nbytes);
+                fprintf(stderr, "filename: %s\n", n->filename);
+                fprintf(stderr, "line number: %d\n", n->lineno);
+                fprintf(stderr, "next: %p\n", (void *)n->next);
+                fprintf(stderr, "\n");
+            }
+        }
     }
 }
 
 
 /**********************************************************************
  *
- * User-level functions.
- *
- * NOTE: Normally, the user will not use these functions, but will
- *       use 'malloc' and 'calloc' wrappers defined in "memcheck.h".
+ * Guarded blocks.
  *
  **********************************************************************/
 
-
 /*
- * Allocate 'size' bytes of memory.  Also add the address, filename, and line
- * number as a new node in the memory pool linked list.
+ * Allocate the memory for a block of 'size' bytes (zeroed if 'zero') in
+ * the given MEMCHECK_GUARD_* mode, and return the address handed to the
+ * user, or NULL if the allocation failed.  '*base' is set to the start of
+ * the underlying allocation and '*span' to the length of the mapping in
+ * guard page mode.
+ *
+ * Canary mode:      [canary][block][canary], one malloc'd region.
+ * Guard page mode:  [unused][canary][block][slack][guard page], one
+ *                   mapping; the block is aligned to GUARD_ALIGN, and the
+ *                   few bytes of slack that alignment leaves before the
+ *                   guard page are filled with canary bytes and checked.
  */
 
 void *
-checked_malloc_fn(size_t size, char *filename, int lineno)
+allocate_block(size_t size, int zero, int guard, void **base, size_t *span)
 {
-    void *mem;
+    size_t page, rounded, data;
+    char *p, *user;
 
-    mem = malloc(size);
+    *span = 0;
 
-    if (mem == NULL)
+    if (guard == MEMCHECK_GUARD_CANARY)
     {
-        fprintf(stderr, "ERROR: memory allocation failed!  Aborting...\n");
-        exit(1);
+        if (size > SIZE_LIMIT - 2 * CANARY_SIZE)
+        {
+            return NULL;
+        }
+        p = zero ? (char *)calloc(1, size + 2 * CANARY_SIZE)
+                 : (char *)malloc(size + 2 * CANARY_SIZE);
+        if (p == NULL)
+        {
+            return NULL;
+        }
+        user = p + CANARY_SIZE;
+        memset(p, CANARY_BYTE, CANARY_SIZE);
+        memset(user + size, CANARY_BYTE, CANARY_SIZE);
+        *base = p;
+        return user;
     }
 
-    allocate_mem_node(mem, size, filename, lineno);
-    return mem;
-}
-
-
-/*
- * This function is the same as 'checked_malloc' except that it has
- * a different signature (corresponding to 'calloc' in the first two
- * arguments) and zeroes out all the allocated memory.
- */
-
-void *
-checked_calloc_fn(size_t nmemb, size_t size, char *filename, int lineno)
-{
-    void *mem;
+    if (guard == MEMCHECK_GUARD_PAGES)
+    {
+        page = (size_t)sysconf(_SC_PAGESIZE);
+        if (size > SIZE_LIMIT - GUARD_ALIGN - CANARY_SIZE - 2 * page)
+        {
+            return NULL;
+        }
+        rounded = (size + GUARD_ALIGN - 1) / GUARD_ALIGN * GUARD_ALIGN;
+        data = (rounded + CANARY_SIZE + page - 1) / page * page;
 
-    mem = calloc(nmemb, size);
+        p = (char *)mmap(NULL, data + page, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == (char *)MAP_FAILED)
+        {
+            return NULL;
+        }
+        if (mprotect(p + data, page, PROT_NONE) != 0)
+        {
+            munmap(p, data + page);
+            return NULL;
+        }
 
-    if (mem == NULL)
-    {
-        fprintf(stderr, "ERROR: memory allocation failed!  Aborting...\n");
-        exit(1);
+        /* Fresh anonymous pages are already zeroed. */
+        user = p + data - rounded;
+        memset(user - CANARY_SIZE, CANARY_BYTE, CANARY_SIZE);
+        memset(user + size, CANARY_BYTE, rounded - size);
+        *base = p;
+        *span = data + page;
+        return user;
     }
 
-    allocate_mem_node(mem, (nmemb * size), filename, lineno);
-    return mem;
+    p = zero ? (char *)calloc(1, size) : (char *)malloc(size);
+    *base = p;
+    return p;
 }
 
 
-/*
- * Free a pointer that was previously allocated by 'checked_malloc()'.  If
- * the memory being freed is not found in the memory pool, print an error
- * message and abort.
- */
+/* Release the memory of a block allocated by allocate_block(). */
 
 void
-checked_free_fn(void *ptr, char *filename, int lineno)
+release_block(mem_node *n)
 {
-    mem_node *n = find_node(ptr);
-
-    if (n == NULL)
+    if (n->guard == MEMCHECK_GUARD_PAGES)
     {
-        fprintf(stderr,
-                "ERROR: invalid attempt to free unallocated memory at %p "
-                "in file: %s, line: %d\n", ptr, filename, lineno);
-        fprintf(stderr, "Aborting...\n");
-        free_all_mem_nodes();
-        exit(1);
+        munmap(n->base, n->span);
     }
     else
     {
-        free_mem_node_and_adjust_pool(n);
+        free(n->base);
     }
 }
 
 
 /*
- * This function is intended to be called at the end of a program only.
- * It goes through the memory pool node-by-node and prints out information
- * on the contents of the node.  Any nodes that exist at the end of the
- * program represent leaked memory.
+ * Return 1 if the 'len' (at most CANARY_SIZE) bytes at 'p' are all
+ * CANARY_BYTE, otherwise 0.
  */
 
-void
-print_memory_leaks(void)
+static int
+canary_intact(unsigned char *p, size_t len)
 {
-    mem_node *n;
+    return memcmp(p, canary_pattern, len) == 0;
+}
 
-    for (n = pool; n != NULL; n = n->next)
-    {
-        fprintf(stderr,
-                "Memory leak: %d bytes allocated at %p in "
-                "file: %s, line: %d.\n",
-                (int)n->nbytes, n->addr, n->filename, n->lineno);
-    }
+
+/*
+ * Check the canaries of a guarded block.  If either has been overwritten,
+ * report it (saying where the check was made: 'filename' and 'lineno',
+ * or at exit if 'filename' is NULL) and return 1.  Otherwise return 0.
+ */
+
+int
+check_block(mem_node *n, char *filename, int lineno)
+{
+    unsigned char *user = (unsigned char *)n->addr;
+    size_t trailer;
+    int under, over;
+
+    if (n->guard == MEMCHECK_GUARD_NONE)
+    {
+        return 0;
+    }
+
+    if (n->guard == MEMCHECK_GUARD_CANARY)
+    {
+        trailer = CANARY_SIZE;
+    }
+    else
+    {
+        trailer = (GUARD_ALIGN - n->nbytes % GUARD_ALIGN) % GUARD_ALIGN;
+    }
+
+    under = !canary_intact(user - CANARY_SIZE, CANARY_SIZE);
+    over = !canary_intact(user + n->nbytes, trailer);
+
+    if (!under && !over)
+    {
+        return 0;
+    }
+
+    fprintf(stderr, "ERROR: memory corruption: %s of %d-byte block at %p "
+            "allocated in file: %s, line: %d",
+            under ? (over ? "underrun and overrun" : "underrun") : "overrun",
+            (int)n->nbytes, n->addr, n->filename, n->lineno);
+    if (filename != NULL)
+    {
+        fprintf(stderr, "; detected on free in file: %s, line: %d\n",
+                filename, lineno);
+    }
+    else
+    {
+        fprintf(stderr, "; detected at exit\n");
+    }
+    return 1;
+}
+
+
+/*
+ * Choose how blocks allocated from now on are guarded: one of the
+ * MEMCHECK_GUARD_* constants.  Overrides MEMCHECK_GUARD.  Blocks already
+ * allocated keep the mode they were allocated with.
+ */
+
+void
+memcheck_set_guard_mode(int mode)
+{
+    ensure_settings();
+    __atomic_store_n(&guard_mode, mode, __ATOMIC_RELAXED);
+}
+
+
+/**********************************************************************
+ *
+ * Heap usage and timeline sampling.
+ *
+ **********************************************************************/
+
+/* Return the number of seconds since sampling was set up. */
+
+static double
+elapsed_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_time.tv_sec)
+        + (now.tv_nsec - start_time.tv_nsec) * 1e-9;
+}
+
+
+/*
+ * Read the settings from the environment (run once, before the first
+ * allocation): MEMCHECK_SAMPLE_EVERY=N samples every Nth allocation,
+ * MEMCHECK_SAMPLE_INTERVAL=seconds samples at that interval and
+ * MEMCHECK_GUARD=canary or MEMCHECK_GUARD=pages turns on block guards.
+ */
+
+static void
+init_settings(void)
+{
+    char *s;
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    if (pthread_key_create(&tracker_key, retire_tracker) != 0)
+    {
+        out_of_memory();
+    }
+
+    s = getenv("MEMCHECK_SAMPLE_EVERY");
+    if (s != NULL)
+    {
+        sample_every = strtoul(s, NULL, 10);
+    }
+
+    s = getenv("MEMCHECK_SAMPLE_INTERVAL");
+    if (s != NULL)
+    {
+        sample_interval = atof(s);
+        next_sample_time = sample_interval;
+    }
+
+    memset(canary_pattern, CANARY_BYTE, CANARY_SIZE);
+
+    s = getenv("MEMCHECK_GUARD");
+    if (s != NULL && strcmp(s, "canary") == 0)
+    {
+        guard_mode = MEMCHECK_GUARD_CANARY;
+    }
+    else if (s != NULL && strcmp(s, "pages") == 0)
+    {
+        guard_mode = MEMCHECK_GUARD_PAGES;
+    }
+
+    __atomic_store_n(&settings_ready, 1, __ATOMIC_RELEASE);
+}
+
+
+/* Make sure the settings have been read. */
+
+static void
+ensure_settings(void)
+{
+    if (!__atomic_load_n(&settings_ready, __ATOMIC_ACQUIRE))
+    {
+        pthread_once(&settings_once, init_settings);
+    }
+}
+
+
+/* Record a sample in the ring buffer.  Called with 'timeline_lock' held. */
+
+static void
+take_sample(unsigned long allocs, double seconds)
+{
+    memcheck_sample *sample = &timeline[timeline_count % TIMELINE_SIZE];
+
+    sample->allocs = allocs;
+    sample->seconds = seconds;
+    sample->live_bytes = __atomic_load_n(&live_bytes, __ATOMIC_RELAXED);
+    timeline_count++;
+}
+
+
+/*
+ * Account for a new allocation of 'nbytes': update the live and peak
+ * byte counts, and take a timeline sample if one is due.  The global
+ * allocation count is only kept while sampling is on; the clock is
+ * checked on every CLOCK_CHECK_EVERY-th allocation of each thread
+ * (counted by 'thread_clock').
+ */
+
+void
+note_allocation(size_t nbytes, unsigned long thread_clock)
+{
+    size_t live, peak;
+    unsigned long count;
+    double t;
+
+    live = __atomic_add_fetch(&live_bytes, nbytes, __ATOMIC_RELAXED);
+    peak = __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak
+           && !__atomic_compare_exchange_n(&peak_bytes, &peak, live, 1,
+                                           __ATOMIC_RELAXED,
+                                           __ATOMIC_RELAXED))
+    {
+        /* 'peak' now holds the current value; try again. */
+    }
+
+    if (sample_every == 0 && sample_interval <= 0.0)
+    {
+        return;
+    }
+
+    count = __atomic_add_fetch(&total_allocs, 1, __ATOMIC_RELAXED);
+
+    if (sample_every > 0 && count % sample_every == 0)
+    {
+        pthread_mutex_lock(&timeline_lock);
+        take_sample(count, elapsed_seconds());
+        pthread_mutex_unlock(&timeline_lock);
+    }
+    else if (sample_interval > 0.0 && thread_clock % CLOCK_CHECK_EVERY == 0)
+    {
+        t = elapsed_seconds();
+        pthread_mutex_lock(&timeline_lock);
+        if (t >= next_sample_time)
+        {
+            take_sample(count, t);
+            next_sample_time = t + sample_interval;
+        }
+        pthread_mutex_unlock(&timeline_lock);
+    }
+}
+
+
+/* Account for the free of a block of 'nbytes'. */
+
+void
+note_free(size_t nbytes)
+{
+    __atomic_sub_fetch(&live_bytes, nbytes, __ATOMIC_RELAXED);
+}
+
+
+size_t
+memcheck_live_bytes(void)
+{
+    return __atomic_load_n(&live_bytes, __ATOMIC_RELAXED);
+}
+
+
+size_t
+memcheck_peak_bytes(void)
+{
+    return __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED);
+}
+
+
+/*
+ * Sample the live byte count every 'every_n' allocations and/or every
+ * 'interval' seconds (zero turns either off).  Overrides the settings
+ * from the environment.
+ */
+
+void
+memcheck_set_sampling(unsigned long every_n, double interval)
+{
+    ensure_settings();
+
+    pthread_mutex_lock(&timeline_lock);
+    sample_every = every_n;
+    sample_interval = interval;
+    next_sample_time = elapsed_seconds() + interval;
+    pthread_mutex_unlock(&timeline_lock);
+}
+
+
+/*
+ * Copy up to 'max' of the most recent timeline samples, oldest first,
+ * into 'samples'.  Return the number copied.
+ */
+
+int
+memcheck_timeline(memcheck_sample *samples, int max)
+{
+    long first, i;
+    int n = 0;
+
+    pthread_mutex_lock(&timeline_lock);
+
+    first = timeline_count - max;
+    if (first < timeline_count - TIMELINE_SIZE)
+    {
+        first = timeline_count - TIMELINE_SIZE;
+    }
+    if (first < 0)
+    {
+        first = 0;
+    }
+
+    for (i = first; i < timeline_count; i++)
+    {
+        samples[n++] = timeline[i % TIMELINE_SIZE];
+    }
+
+    pthread_mutex_unlock(&timeline_lock);
+    return n;
+}
+
+
+/*
+ * Print the timeline (oldest sample first) as CSV, followed by the
+ * current and peak live byte counts as comments.
+ */
+
+void
+memcheck_dump_timeline(FILE *fp)
+{
+    memcheck_sample *samples;
+    int i, n;
+
+    samples = (memcheck_sample *)malloc(TIMELINE_SIZE
+                                        * sizeof(memcheck_sample));
+
+    if (samples == NULL)
+    {
+        out_of_memory();
+    }
+
+    n = memcheck_timeline(samples, TIMELINE_SIZE);
+
+    fprintf(fp, "allocs,seconds,live_bytes\n");
+    for (i = 0; i < n; i++)
+    {
+        fprintf(fp, "%lu,%.6f,%lu\n", samples[i].allocs,
+                samples[i].seconds, (unsigned long)samples[i].live_bytes);
+    }
+    fprintf(fp, "# live bytes: %lu, peak live bytes: %lu\n",
+            (unsigned long)memcheck_live_bytes(),
+            (unsigned long)memcheck_peak_bytes());
+
+    free(samples);
+}
+
+
+/**********************************************************************
+ *
+ * User-level functions.
+ *
+ * NOTE: Normally, the user will not use these functions, but will
+ *       use 'malloc' and 'calloc' wrappers defined in "memcheck.h".
+ *
+ **********************************************************************/
+
+
+/*
+ * Allocate a block of 'size' bytes (zeroed if 'zero'), guarded according
+ * to the current guard mode, and record it in the calling thread's pool.
+ */
+
+static void *
+checked_alloc(size_t size, int zero, char *filename, int lineno)
+{
+    void *mem, *base;
+    size_t span;
+    int guard;
+
+    ensure_settings();
+    guard = __atomic_load_n(&guard_mode, __ATOMIC_RELAXED);
+    mem = allocate_block(size, zero, guard, &base, &span);
+
+    if (mem == NULL)
+    {
+        fprintf(stderr, "ERROR: memory allocation failed!  Aborting...\n");
+        exit(1);
+    }
+
+    allocate_mem_node(mem, size, filename, lineno, guard, base, span);
+    return mem;
+}
+
+
+/*
+ * Allocate 'size' bytes of memory.  Also add the address, filename, and line
+ * number as a new node in the calling thread's memory pool.
+ */
+
+void *
+checked_malloc_fn(size_t size, char *filename, int lineno)
+{
+    return checked_alloc(size, 0, filename, lineno);
+}
+
+
+/*
+ * This function is the same as 'checked_malloc' except that it has
+ * a different signature (corresponding to 'calloc' in the first two
+ * arguments) and zeroes out all the allocated memory.  A request whose
+ * total size overflows a size_t fails like any other allocation.
+ */
+
+void *
+checked_calloc_fn(size_t nmemb, size_t size, char *filename, int lineno)
+{
+    if (size != 0 && nmemb > SIZE_LIMIT / size)
+    {
+        out_of_memory();
+    }
+
+    return checked_alloc(nmemb * size, 1, filename, lineno);
+}
+
+
+/*
+ * Free a pointer that was previously allocated by 'checked_malloc()'.  The
+ * calling thread's own pool is searched first; if the block isn't there it
+ * was allocated by another thread, so the other pools are searched.  If
+ * the memory being freed is not found in any pool, print an error message
+ * and abort.
+ */
+
+void
+checked_free_fn(void *ptr, char *filename, int lineno)
+{
+    mem_tracker *self = my_tracker;
+    mem_tracker *t;
+    int found, multithreaded;
+
+    found = 0;
+    if (self != NULL)
+    {
+        found = free_mem_node_and_adjust_pool(self, ptr, filename, lineno);
+    }
+
+    if (found == 1)
+    {
+        return;
+    }
+
+    /*
+     * Trackers with nothing live can't hold the block, so skip them
+     * without taking their locks.  (The block was allocated before this
+     * call, so its tracker's count can't be seen as zero here.)
+     */
+    pthread_mutex_lock(&registry_lock);
+
+    for (t = trackers; t != NULL && !found; t = t->next)
+    {
+        if (t != self
+            && __atomic_load_n(&t->pool_count, __ATOMIC_RELAXED) > 0)
+        {
+            found = free_mem_node_and_adjust_pool(t, ptr, filename, lineno);
+        }
+    }
+
+    multithreaded = (nthreads > 1);
+    pthread_mutex_unlock(&registry_lock);
+
+    if (found == 2)
+    {
+        /* The corruption has already been reported. */
+        fprintf(stderr, "Aborting...\n");
+        free_all_mem_nodes();
+        exit(1);
+    }
+
+    if (!found)
+    {
+        fprintf(stderr,
+                "ERROR: invalid attempt to free unallocated memory at %p "
+                "in file: %s, line: %d", ptr, filename, lineno);
+        if (multithreaded && self != NULL)
+        {
+            fprintf(stderr, " (thread %d)", my_thread_num);
+        }
+        fprintf(stderr, "\n");
+        fprintf(stderr, "Aborting...\n");
+        free_all_mem_nodes();
+        exit(1);
+    }
+}
+
+
+/*
+ * Order call sites by total bytes allocated, then by number of
+ * allocations, largest first.  Used with qsort().
+ */
+
+static int
+compare_sites(const void *a, const void *b)
+{
+    const alloc_site *sa = *(const alloc_site * const *)a;
+    const alloc_site *sb = *(const alloc_site * const *)b;
+
+    if (sa->nbytes != sb->nbytes)
+    {
+        return (sa->nbytes < sb->nbytes) ? 1 : -1;
+    }
+    if (sa->nallocs != sb->nallocs)
+    {
+        return (sa->nallocs < sb->nallocs) ? 1 : -1;
+    }
+    if (sa->lineno != sb->lineno)
+    {
+        return sa->lineno - sb->lineno;
+    }
+    return strcmp(sa->filename, sb->filename);
+}
+
+
+/* Order call sites by filename pointer and line.  Used with qsort(). */
+
+static int
+compare_site_keys(const void *a, const void *b)
+{
+    const alloc_site *sa = (const alloc_site *)a;
+    const alloc_site *sb = (const alloc_site *)b;
+
+    if (sa->filename != sb->filename)
+    {
+        return ((unsigned long)sa->filename < (unsigned long)sb->filename)
+            ? -1 : 1;
+    }
+    return sa->lineno - sb->lineno;
+}
+
+
+/*
+ * Merge the call site tables of all the trackers and return a newly
+ * allocated array of pointers to the merged sites, ranked by
+ * compare_sites().  The merged sites live in '*storage'; the caller
+ * frees both arrays.  Per-thread peaks are added together, so a merged
+ * peak is an upper bound when several threads allocate at one site.
+ */
+
+static alloc_site **
+ranked_sites(alloc_site **storage, size_t *count)
+{
+    mem_tracker *t;
+    alloc_site *all, *site, **ranked;
+    size_t i, n, total;
+
+    /*
+     * Other threads may still be adding sites, so each tracker's sites
+     * are counted and copied under the same hold of its lock, growing
+     * 'all' to fit first.
+     */
+    all = (alloc_site *)malloc(sizeof(alloc_site));
+    if (all == NULL)
+    {
+        out_of_memory();
+    }
+    n = 0;
+
+    pthread_mutex_lock(&registry_lock);
+
+    for (t = trackers; t != NULL; t = t->next)
+    {
+        pthread_mutex_lock(&t->lock);
+        all = (alloc_site *)realloc(all,
+                                    (n + t->nsites + 1) * sizeof(alloc_site));
+        if (all == NULL)
+        {
+            out_of_memory();
+        }
+        for (i = 0; i < SITE_BUCKETS; i++)
+        {
+            for (site = t->sites[i]; site != NULL; site = site->next)
+            {
+                all[n++] = *site;
+            }
+        }
+        pthread_mutex_unlock(&t->lock);
+    }
+
+    pthread_mutex_unlock(&registry_lock);
+
+    ranked = (alloc_site **)malloc((n + 1) * sizeof(alloc_site *));
+    if (ranked == NULL)
+    {
+        out_of_memory();
+    }
+
+    /* Sort by site, then fold each run of equal sites into its first. */
+    qsort(all, n, sizeof(alloc_site), compare_site_keys);
+
+    total = 0;
+    for (i = 0; i < n; i++)
+    {
+        if (total > 0 && compare_site_keys(&all[total - 1], &all[i]) == 0)
+        {
+            site = &all[total - 1];
+            site->nallocs += all[i].nallocs;
+            site->nfrees += all[i].nfrees;
+            site->nbytes += all[i].nbytes;
+            site->live_bytes += all[i].live_bytes;
+            site->peak_live_bytes += all[i].peak_live_bytes;
+            site->total_lifetime += all[i].total_lifetime;
+        }
+        else
+        {
+            all[total++] = all[i];
+        }
+    }
+
+    for (i = 0; i < total; i++)
+    {
+        ranked[i] = &all[i];
+    }
+    qsort(ranked, total, sizeof(alloc_site *), compare_sites);
+
+    *storage = all;
+    *count = total;
+    return ranked;
+}
+
+
+/*
+ * Print the allocation profile: one line per call site, ranked by total
+ * bytes allocated.  Average lifetimes are in allocations (see above) and
+ * only count blocks that have been freed.
+ */
+
+void
+print_allocation_profile(FILE *fp)
+{
+    alloc_site **ranked, *storage, *site;
+    size_t i, n;
+
+    ranked = ranked_sites(&storage, &n);
+
+    fprintf(fp, "%10s %14s %12s %12s %12s  %s\n", "allocs", "bytes",
+            "peak live", "live", "avg life", "call site");
+
+    for (i = 0; i < n; i++)
+    {
+        site = ranked[i];
+        fprintf(fp, "%10lu %14.0f %12.0f %12.0f %12.1f  %s:%d\n",
+                site->nallocs, site->nbytes, site->peak_live_bytes,
+                site->live_bytes,
+                site->nfrees ? site->total_lifetime / site->nfrees : 0.0,
+                site->filename, site->lineno);
+    }
+
+    free(ranked);
+    free(storage);
+}
+
+
+/*
+ * Write the allocation profile in CSV form, in the same order as
+ * print_allocation_profile().
+ */
+
+void
+write_allocation_profile_csv(FILE *fp)
+{
+    alloc_site **ranked, *storage, *site;
+    size_t i, n;
+
+    ranked = ranked_sites(&storage, &n);
+
+    fprintf(fp, "file,line,allocs,frees,bytes,peak_live_bytes,live_bytes,"
+            "avg_lifetime\n");
+
+    for (i = 0; i < n; i++)
+    {
+        site = ranked[i];
+        fprintf(fp, "%s,%d,%lu,%lu,%.0f,%.0f,%.0f,%.1f\n",
+                site->filename, site->lineno, site->nallocs, site->nfrees,
+                site->nbytes, site->peak_live_bytes, site->live_bytes,
+                site->nfrees ? site->total_lifetime / site->nfrees : 0.0);
+    }
+
+    free(ranked);
+    free(storage);
+}
+
+
+/*
+ * Dump the allocation profile and timeline if the environment asks for
+ * them: MEMCHECK_PROFILE (any value) prints the ranked report and the
+ * peak heap usage to stderr, MEMCHECK_PROFILE_CSV=path writes the CSV
+ * form of the profile to 'path' and MEMCHECK_TIMELINE=path writes the
+ * timeline to 'path'.
+ */
+
+static void
+dump_requested_profiles(void)
+{
+    char *csv_path, *timeline_path;
+    FILE *fp;
+
+    if (getenv("MEMCHECK_PROFILE") != NULL)
+    {
+        print_allocation_profile(stderr);
+        fprintf(stderr, "Peak live bytes: %lu\n",
+                (unsigned long)memcheck_peak_bytes());
+    }
+
+    timeline_path = getenv("MEMCHECK_TIMELINE");
+    if (timeline_path != NULL)
+    {
+        fp = fopen(timeline_path, "w");
+        if (fp == NULL)
+        {
+            fprintf(stderr, "ERROR: cannot write heap timeline to "
+                    "\"%s\"\n", timeline_path);
+        }
+        else
+        {
+            memcheck_dump_timeline(fp);
+            fclose(fp);
+        }
+    }
+
+    csv_path = getenv("MEMCHECK_PROFILE_CSV");
+    if (csv_path != NULL)
+    {
+        fp = fopen(csv_path, "w");
+        if (fp == NULL)
+        {
+            fprintf(stderr, "ERROR: cannot write allocation profile to "
+                    "\"%s\"\n", csv_path);
+        }
+        else
+        {
+            write_allocation_profile_csv(fp);
+            fclose(fp);
+        }
+    }
+}
+
+
+/*
+ * This function is intended to be called at the end of a program only,
+ * after any other threads have finished allocating.  It goes through the
+ * memory pools node-by-node and prints out information on the contents of
+ * the node.  Any nodes that exist at the end of the program represent
+ * leaked memory.  When more than one thread has allocated memory, each
+ * leak is tagged with the thread that allocated it.  Guarded blocks that
+ * are still live have their canaries checked.  The allocation profile is
+ * dumped first if the environment asks for it (see
+ * dump_requested_profiles()).
+ */
+
+void
+print_memory_leaks(void)
+{
+    mem_tracker *t;
+    mem_node *n;
+    size_t i;
+
+    dump_requested_profiles();
+
+    pthread_mutex_lock(&registry_lock);
+
+    for (t = trackers; t != NULL; t = t->next)
+    {
+        pthread_mutex_lock(&t->lock);
+        for (i = 0; i < t->pool_buckets; i++)
+        {
+            for (n = t->pool[i]; n != NULL; n = n->next)
+            {
+                check_block(n, NULL, 0);
+                fprintf(stderr,
+                        "Memory leak: %d bytes allocated at %p in "
+                        "file: %s, line: %d",
+                        (int)n->nbytes, n->addr, n->filename, n->lineno);
+                if (nthreads > 1)
+                {
+                    fprintf(stderr, " (thread %d)", n->thread_num);
+                }
+                fprintf(stderr, ".\n");
+            }
+        }
+        pthread_mutex_unlock(&t->lock);
+    }
+
+    pthread_mutex_unlock(&registry_lock);
 
     free_all_mem_nodes();
 }
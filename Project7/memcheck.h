@@ -8,6 +8,7 @@
 #ifndef MEMCHECK_H
 #define MEMCHECK_H
 
+#include <stdio.h>
 #include <stdlib.h>
 
 void *checked_malloc_fn(size_t size, char *filename, int lineno);
@@ -16,6 +17,63 @@ void *checked_calloc_fn(size_t nmemb, size_t size,
 void  checked_free_fn(void *ptr, char *filename, int lineno);
 void  print_memory_leaks(void);
 
+/*
+ * Allocation profile: per call site counts, bytes, peak live bytes and
+ * average lifetime, ranked by bytes allocated.  print_memory_leaks()
+ * also dumps these if MEMCHECK_PROFILE (text, to stderr) or
+ * MEMCHECK_PROFILE_CSV=path (CSV) is set in the environment.
+ */
+void  print_allocation_profile(FILE *fp);
+void  write_allocation_profile_csv(FILE *fp);
+
+/*
+ * Heap usage: the number of bytes currently allocated, and the largest
+ * that number has been, over all threads.
+ */
+size_t memcheck_live_bytes(void);
+size_t memcheck_peak_bytes(void);
+
+/*
+ * Heap timeline.  The live byte count can be sampled every 'every_n'
+ * allocations and/or every 'interval' seconds (zero turns either off)
+ * into a ring buffer holding the most recent samples.  Sampling can also
+ * be turned on with MEMCHECK_SAMPLE_EVERY=N and MEMCHECK_SAMPLE_INTERVAL=
+ * seconds; MEMCHECK_TIMELINE=path makes print_memory_leaks() write the
+ * timeline (as CSV) to 'path'.
+ */
+
+typedef struct
+{
+    unsigned long allocs;   /* Allocations made when the sample was taken. */
+    double  seconds;        /* Time since the first allocation.            */
+    size_t  live_bytes;     /* Bytes allocated and not yet freed.          */
+} memcheck_sample;
+
+void  memcheck_set_sampling(unsigned long every_n, double interval);
+
+/* Copy up to 'max' of the latest samples, oldest first; return the count. */
+int   memcheck_timeline(memcheck_sample *samples, int max);
+
+/* Write the timeline as CSV, with the current and peak usage at the end. */
+void  memcheck_dump_timeline(FILE *fp);
+
+/*
+ * Overrun detection.  In canary mode each block is surrounded by canary
+ * bytes, checked when it is freed and by print_memory_leaks(); this is
+ * cheap enough to leave on in performance tests.  In guard page mode
+ * each block is also placed at the end of its own mapping, right before
+ * an inaccessible page, so an overrun faults immediately; this costs a
+ * few system calls and at least two pages per allocation.  The mode can
+ * also be chosen with MEMCHECK_GUARD=canary or MEMCHECK_GUARD=pages, and
+ * applies to blocks allocated after it is set.
+ */
+
+#define MEMCHECK_GUARD_NONE   0
+#define MEMCHECK_GUARD_CANARY 1
+#define MEMCHECK_GUARD_PAGES  2
+
+void  memcheck_set_guard_mode(int mode);
+
 /*
  * Macros which maintain the interface of the standard malloc/calloc/free
  * functions.  Don't include these if this file is being included into
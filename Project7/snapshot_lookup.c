@@ -0,0 +1,48 @@
+/*
+ * FILE: snapshot_lookup.c
+ *
+ *       Look up words in a hash table snapshot written by
+ *       "test_hash_table -w" or "test_hash_table -m".  The snapshot is
+ *       mapped read-only, so lookups start immediately no matter how
+ *       large it is.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "hash_snapshot.h"
+#include "memcheck.h"
+
+
+void usage(char *progname)
+{
+    fprintf(stderr, "usage: %s snapshot word [word ...]\n", progname);
+}
+
+
+int main(int argc, char **argv)
+{
+    hash_snapshot *snap;
+    int i;
+
+    if (argc < 3)
+    {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    snap = open_hash_snapshot(argv[1]);
+    if (snap == NULL)
+    {
+        return 1;
+    }
+
+    for (i = 2; i < argc; i++)
+    {
+        printf("%s %d\n", argv[i], snapshot_get_value(snap, argv[i]));
+    }
+
+    close_hash_snapshot(snap);
+    print_memory_leaks();
+    return 0;
+}